@@ -1,479 +1,643 @@
-#include <iostream>
-#include <queue>
-#include <vector>
-#include <unordered_set>
-#include <stack>
-#include <cmath>
-using namespace std;
-
-#define SIZE 3
-
-int explored_node = 0;
-int expanded_node = 0;
-
-class search_node
-{
-public:
-    int size;
-    vector<vector<int>> current_board_configuration = vector<vector<int>>(SIZE, vector<int>(SIZE));
-    double priority_value;
-    search_node *parent_node;
-    pair<int, int> empty_tile_position;
-    double (*heuristic_function)(const search_node &);
-    double g_n = 0;
-    double h_n = 0;
-
-public:
-    search_node(int size_,
-                double (*h_fn)(const search_node &) = nullptr)
-        : size(size_),
-          current_board_configuration(size_, vector<int>(size_)),
-          priority_value(0),
-          parent_node(nullptr),
-          heuristic_function(h_fn),
-          g_n(0),
-          h_n(0)
-    {
-        for (int i = 0; i < size; i++)
-        {
-            for (int j = 0; j < size; j++)
-            {
-                int input;
-                cin >> input;
-                current_board_configuration[i][j] = input;
-                if (input == 0)
-                    empty_tile_position = {i, j};
-            }
-        }
-        h_n = heuristic_function
-                  ? heuristic_function(*this)
-                  : 0;
-        priority_value = g_n + h_n;
-    }
-    search_node(const search_node &node)
-        : size(node.size),
-          current_board_configuration(node.current_board_configuration),
-          priority_value(node.priority_value),
-          parent_node(node.parent_node),
-          empty_tile_position(node.empty_tile_position),
-          heuristic_function(node.heuristic_function),
-          g_n(node.g_n),
-          h_n(node.h_n)
-    {
-    }
-    void print_current_configuration()
-    {
-        for (int i = 0; i < size; i++)
-        {
-            for (int j = 0; j < size; j++)
-            {
-                cout << current_board_configuration[i][j] << " ";
-            }
-            cout << endl;
-        }
-    }
-    string get_board_string()
-    {
-        string config = "";
-        for (int i = 0; i < size; i++)
-        {
-            for (int j = 0; j < size; j++)
-            {
-                config += to_string(current_board_configuration[i][j]) + ",";
-            }
-        }
-        return config;
-    }
-
-    void set_heuristic_function(double (*heuristic_function)(const search_node &))
-    {
-        this->heuristic_function = heuristic_function;
-    }
-};
-
-struct ComparePriority
-{
-    bool operator()(search_node *const &n1,
-                    search_node *const &n2) const
-    {
-        if (n1->priority_value == n2->priority_value)
-        {
-            return n1->h_n > n2->h_n;
-        }
-        return n1->priority_value > n2->priority_value;
-    }
-};
-
-unordered_set<string> closed_list;
-priority_queue<search_node *, vector<search_node *>, ComparePriority> open_list;
-vector<search_node *> all_allocated_nodes;
-
-bool solvable(search_node &node, int size = 3)
-{
-    vector<int> config;
-    int inversions = 0;
-
-    for (int i = 0; i < size; i++)
-    {
-        for (int j = 0; j < size; j++)
-        {
-            int val = node.current_board_configuration[i][j];
-            if (val != 0)
-                config.push_back(val);
-        }
-    }
-
-    for (int i = 0; i < config.size() - 1; i++)
-    {
-        for (int j = i + 1; j < config.size(); j++)
-        {
-            if (config[i] > config[j])
-                inversions++;
-        }
-    }
-
-    cout << "inversions: " << inversions << endl;
-
-    // Solvability condition
-    if (size % 2 != 0)
-        return inversions % 2 == 0;
-    else
-    {
-        int row_from_bottom = size - node.empty_tile_position.first;
-        if (row_from_bottom % 2 == 0) // empty tile is on an even row from the bottom
-        {
-            return inversions % 2 != 0;
-        }
-        else // empty tile is on an odd row from the bottom
-        {
-            return inversions % 2 == 0;
-        }
-    }
-}
-
-void generate_children(search_node &node)
-{
-    int row = node.empty_tile_position.first;
-    int col = node.empty_tile_position.second;
-    // move up
-    if (row > 0)
-    {
-        search_node *child = new search_node(node);
-        child->parent_node = &node;
-        swap(child->current_board_configuration[row][col], child->current_board_configuration[row - 1][col]);
-        child->empty_tile_position = {row - 1, col};
-        child->g_n = node.g_n + 1;
-        child->h_n = child->heuristic_function(*child);
-        child->priority_value = child->g_n + child->h_n;
-        string board_string = child->get_board_string();
-        if (closed_list.find(board_string) == closed_list.end())
-        {
-            open_list.push(child);
-            explored_node++;
-            all_allocated_nodes.push_back(child);
-            closed_list.insert(board_string);
-        }else{
-            delete child; 
-        }
-    }
-    // move down
-    if (row < node.size - 1)
-    {
-        search_node *child = new search_node(node);
-        swap(child->current_board_configuration[row][col], child->current_board_configuration[row + 1][col]);
-        child->parent_node = &node;
-        child->empty_tile_position = make_pair(row + 1, col);
-        child->g_n = node.g_n + 1;
-        child->h_n = child->heuristic_function(*child);
-        child->priority_value = child->g_n + child->h_n;
-        string board_string = child->get_board_string();
-        if (closed_list.find(board_string) == closed_list.end())
-        {
-            open_list.push(child);
-            explored_node++;
-            all_allocated_nodes.push_back(child);
-            closed_list.insert(board_string);
-        }else{
-            delete child;
-        }
-    }
-    // move left
-    if (col > 0)
-    {
-        search_node *child = new search_node(node);
-        child->parent_node = &node;
-        swap(child->current_board_configuration[row][col], child->current_board_configuration[row][col - 1]);
-        child->empty_tile_position = make_pair(row, col - 1);
-        child->g_n = node.g_n + 1;
-        child->h_n = child->heuristic_function(*child);
-        child->priority_value = child->g_n + child->h_n;
-        string board_string = child->get_board_string();
-        if (closed_list.find(board_string) == closed_list.end())
-        {
-            open_list.push(child);
-            explored_node++;
-            all_allocated_nodes.push_back(child);
-            closed_list.insert(board_string);
-        }else{
-            delete child; 
-        }
-    }
-    // move right
-    if (col < node.size - 1)
-    {
-        search_node *child = new search_node(node);
-        child->parent_node = &node;
-        swap(child->current_board_configuration[row][col], child->current_board_configuration[row][col + 1]);
-        child->empty_tile_position = make_pair(row, col + 1);
-        child->g_n = node.g_n + 1;
-        child->h_n = child->heuristic_function(*child);
-        child->priority_value = child->g_n + child->h_n;
-        string board_string = child->get_board_string();
-        if (closed_list.find(board_string) == closed_list.end())
-        {
-            open_list.push(child);
-            explored_node++;
-            all_allocated_nodes.push_back(child);
-            closed_list.insert(board_string);
-        }else{
-            delete child; // Avoid memory leak if the node is already in closed_list
-        }
-    }
-}
-
-double hamming_distance(const search_node &node)
-{
-    double distance = 0;
-    for (int i = 0; i < node.size; i++)
-    {
-        for (int j = 0; j < node.size; j++)
-        {
-            int expected_value = (i * node.size + j + 1) % (node.size * node.size);
-            if (node.current_board_configuration[i][j] != expected_value)
-            {
-                distance++;
-            }
-        }
-    }
-    return distance;
-}
-
-double manhattan_distane(const search_node &node)
-{
-    double distance = 0;
-    for (int i = 0; i < node.size; i++)
-    {
-        for (int j = 0; j < node.size; j++)
-        {
-            int value = node.current_board_configuration[i][j];
-            if (value != 0)
-            {
-                int expected_row = (value - 1) / node.size;
-                int expected_col = (value - 1) % node.size;
-                distance += abs(expected_row - i) + abs(expected_col - j);
-            }
-        }
-    }
-
-    return distance;
-}
-
-double euclidean_distance(const search_node &node)
-{
-    double distance = 0;
-    for (int i = 0; i < node.size; i++)
-    {
-        for (int j = 0; j < node.size; j++)
-        {
-            int value = node.current_board_configuration[i][j];
-            if (value != 0)
-            {
-                int expected_row = (value - 1) / node.size;
-                int expected_col = (value - 1) % node.size;
-                distance += sqrt(pow(expected_row - i, 2) + pow(expected_col - j, 2));
-            }
-        }
-    }
-
-    return distance;
-}
-
-double linear_conflict(const search_node &node)
-{
-    int size = node.size;
-    const auto &grid = node.current_board_configuration;
-    int conflicts = 0;
-
-    for (int i = 0; i < size; ++i)
-    {
-        for (int j = 0; j < size; ++j)
-        {
-            int value1 = grid[i][j];
-            if (value1 == 0)
-                continue;
-            int correct_row_value1 = (value1 - 1) / size;
-            int correct_col_value2 = (value1 - 1) % size;
-            if (correct_row_value1 != i)
-                continue; // Row te belong na korle conitnue
-
-            for (int k = j + 1; k < size; ++k)
-            {
-                int value2 = grid[i][k];
-
-                if (value2 == 0)
-                    continue;
-                int correct_row_value2 = (value2 - 1) / size;
-                int correct_col_value1 = (value2 - 1) % size;
-                if (correct_col_value2 != i) // Correct row te belong kortese na
-                    continue;
-                if (correct_col_value1 > correct_col_value2) // Order is wrong
-                    conflicts++;
-            }
-        }
-    }
-
-    // Column conflicts
-    for (int j = 0; j < size; ++j)
-    {
-        for (int i = 0; i < size; ++i)
-        {
-            int value1 = grid[i][j];
-            if (value1 == 0)
-                continue;
-            int correct_row_value1 = (value1 - 1) / size;
-            int correct_col_value1 = (value1 - 1) % size;
-            if (correct_col_value1 != j)
-                continue; // correct column e belong kortese na
-
-            for (int k = i + 1; k < size; ++k)
-            {
-                int value2 = grid[k][j];
-                if (value2 == 0)
-                    continue;
-                int correct_row_value2 = (value2 - 1) / size;
-                int correct_col_value2 = (value2 - 1) % size;
-                if (correct_col_value2 != j) // correct column e belong kortese na
-                    continue;
-
-                if (correct_row_value1 > correct_row_value2)
-                    conflicts++;
-            }
-        }
-    }
-    double total_distance = manhattan_distane(node) + 2 * conflicts;
-    return total_distance;
-}
-
-search_node *puzzle_solver(const string &correct_configuration)
-{
-    while (!open_list.empty())
-    {
-        search_node *promising_node = open_list.top();
-        open_list.pop();
-        expanded_node++;
-        if (promising_node->get_board_string() == correct_configuration)
-        {
-            cout << "solved\n";
-            return promising_node;
-        }
-        generate_children(*promising_node);
-    }
-    cout << "no solution\n";
-    return nullptr;
-}
-
-int main(int argc, char *argv[])
-{
-    int n;
-    cin >> n;
-    int heuristic_choice;
-    search_node *node = new search_node(n, hamming_distance);
-    if (argc < 2)
-    {
-        cout << "Missing arguement" << endl;
-        return 0;
-    }
-    switch (argv[1][0])
-    {
-    case '1':
-        node->set_heuristic_function(hamming_distance);
-        cout << "Heuristic function: Hamming distance" << endl;
-        break;
-    case '2':
-        node->set_heuristic_function(manhattan_distane);
-        cout << "Heuristic function: Manhattan distance" << endl;
-        break;
-    case '3':
-        node->set_heuristic_function(euclidean_distance);
-        cout << "Heuristic function: Euclidean distance" << endl;
-        break;
-    case '4':
-        node->set_heuristic_function(linear_conflict);
-        cout << "Heuristic function: Linear conflict" << endl;
-        break;
-    default:
-        break;
-    }
-
-    node->g_n = 0;
-    node->h_n = node->heuristic_function(*node);
-    node->priority_value = node->g_n + node->h_n;
-    bool solvable_flag = solvable(*node, n);
-
-    if (!solvable_flag)
-    {
-        cout << "not solvable" << endl;
-        delete node;
-        return 0;
-    }
-
-    open_list.push(node);
-    all_allocated_nodes.push_back(node);
-
-    explored_node++;
-
-    closed_list.insert(node->get_board_string());
-
-    string correct_configuration = "";
-
-    for (int i = 0; i < n; i++)
-    {
-        for (int j = 0; j < n; j++)
-        {
-            int reference_value = (i * n + j + 1) % (n * n);
-            correct_configuration += to_string(reference_value) + ",";
-        }
-    }
-
-    search_node *correct_config = puzzle_solver(correct_configuration);
-
-    stack<search_node *> path;
-    int path_length = 0;
-    while (correct_config != nullptr)
-    {
-        path.push(correct_config);
-        path_length++;
-        correct_config = correct_config->parent_node;
-    }
-
-    cout << "Minimum number of moves = " << --path_length << endl;
-    while (!path.empty())
-    {
-        search_node *step = path.top();
-        path.pop();
-        step->print_current_configuration();
-        cout << endl;
-    }
-    cout << "Explored node: " << explored_node << endl;
-    cout << "Expanded node: " << expanded_node << endl;
-    while (!all_allocated_nodes.empty())
-    {
-        search_node *temp = all_allocated_nodes.back();
-        all_allocated_nodes.pop_back();
-        delete temp;
-    }
-    closed_list.clear();
-
-
-    return 0;
-}
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "search_node.h"
+#include "heuristics.h"
+#include "astar.h"
+#include "ida_star.h"
+#include "hda_star.h"
+#include "parallel_ida_star.h"
+#include "epea_star.h"
+#include "bidirectional.h"
+#include "disk_search.h"
+#include "anytime_astar.h"
+#include "distance_table.h"
+#include "pdb_builder.h"
+#include "realtime_solver.h"
+#include "solver_daemon.h"
+#include "batch.h"
+#include "benchmark.h"
+using namespace std;
+
+struct solve_options
+{
+    string mode = "astar";
+    int threads = 1;
+    string directory = DISK_SEARCH_DIRECTORY;
+    size_t memory_mb = 256;
+    double deadline_ms = 1000;
+    double weight = 3;
+    bool compact = false; // print the solution as a UDLR string
+};
+
+// MM from both ends, then forward A* on the same heuristic for comparison.
+template <int W, class heuristic>
+void solve_bidirectional(const search_node<W> &node, const solve_options &options)
+{
+    if constexpr (heuristic::retargetable)
+    {
+        bidirectional_solver<W, heuristic> solver;
+        vector<int> moves;
+        if (solver.solve(node, moves))
+        {
+            cout << "solved" << endl;
+            print_solution(node, moves, options.compact);
+        }
+        else
+            cout << "no solution" << endl;
+        cout << "Explored node: " << solver.explored_node << endl;
+        cout << "Expanded node: " << solver.expanded_node << " (forward " << solver.forward_expanded
+             << ", backward " << solver.backward_expanded << ")" << endl;
+
+        astar_solver<W, heuristic> unidirectional;
+        vector<int> unidirectional_moves;
+        unidirectional.solve(node, unidirectional_moves);
+        cout << "A* explored node: " << unidirectional.explored_node << endl;
+        cout << "A* expanded node: " << unidirectional.expanded_node << endl;
+    }
+    else
+        cout << "This heuristic cannot measure distances to the start board" << endl;
+}
+
+template <int W, class heuristic>
+int solve_puzzle(const search_node<W> &node, const solve_options &options)
+{
+    if (options.mode != "table") // the table gives exact distances, no heuristic
+        cout << "Heuristic function: " << heuristic::name << endl;
+    if (options.mode == "ida")
+        cout << "Search algorithm: IDA*" << endl;
+    else if (options.mode == "pida")
+        cout << "Search algorithm: parallel IDA* (" << options.threads << " threads)" << endl;
+    else if (options.mode == "hda")
+        cout << "Search algorithm: HDA* (" << options.threads << " threads)" << endl;
+    else if (options.mode == "bidir")
+        cout << "Search algorithm: bidirectional MM" << endl;
+    else if (options.mode == "epea")
+        cout << "Search algorithm: enhanced partial-expansion A* (EPEA*)" << endl;
+    else if (options.mode == "anytime")
+        cout << "Search algorithm: anytime weighted A* (ARA*, weight " << options.weight << ", deadline "
+             << options.deadline_ms << " ms)" << endl;
+    else if (options.mode == "table")
+        cout << "Search algorithm: complete distance table (greedy descent)" << endl;
+    else if (options.mode == "disk")
+        cout << "Search algorithm: disk-based breadth-first heuristic search (" << options.directory << ", "
+             << options.memory_mb << " MB)" << endl;
+
+    cout << "inversions: " << count_inversions(node.board) << endl;
+    if (!solvable(node))
+    {
+        cout << "not solvable" << endl;
+        return 0;
+    }
+
+    if (options.mode == "ida")
+    {
+        ida_star_solver<W, heuristic> solver;
+        vector<int> moves;
+        if (solver.solve(node, moves))
+        {
+            cout << "solved" << endl;
+            print_solution(node, moves, options.compact);
+        }
+        else
+            cout << "no solution" << endl;
+        cout << "Explored node: " << solver.explored_node << endl;
+        cout << "Expanded node: " << solver.expanded_node << endl;
+        return 0;
+    }
+
+    if (options.mode == "pida")
+    {
+        parallel_ida_star_solver<W, heuristic> solver(options.threads);
+        vector<int> moves;
+        if (solver.solve(node, moves))
+        {
+            cout << "solved" << endl;
+            print_solution(node, moves, options.compact);
+        }
+        else
+            cout << "no solution" << endl;
+        cout << "Explored node: " << solver.explored_node << endl;
+        cout << "Expanded node: " << solver.expanded_node << endl;
+        cout << "Tasks: " << solver.task_count << " at depth " << solver.split_depth << ", " << solver.stolen_task
+             << " stolen" << endl;
+        for (size_t i = 0; i < solver.thread_expanded.size(); i++)
+        {
+            cout << "Thread " << i << " expanded node: " << solver.thread_expanded[i] << " ("
+                 << 100.0 * solver.thread_expanded[i] / max(1LL, solver.expanded_node) << "%)" << endl;
+        }
+        return 0;
+    }
+
+    if constexpr (W == 3)
+    {
+        if (options.mode == "table")
+        {
+            vector<int> moves;
+            long long lookups;
+            if (eight_puzzle_table.solve(node, moves, lookups))
+            {
+                cout << "solved" << endl;
+                print_solution(node, moves, options.compact);
+            }
+            else
+                cout << "no solution" << endl;
+            cout << "Table lookups: " << lookups << endl;
+            return 0;
+        }
+    }
+
+    if (options.mode == "anytime")
+    {
+        anytime_astar_solver<W, heuristic> solver(options.weight);
+        if (solver.solve(node, options.deadline_ms))
+        {
+            for (const anytime_solution &solution : solver.solutions)
+            {
+                cout << "Solution: " << solution.cost << " moves, weight " << solution.weight << ", bound "
+                     << solution.bound << ", " << solution.ms << " ms, " << solution.expanded << " expanded" << endl;
+            }
+            const anytime_solution &best = solver.solutions.back();
+            print_solution(node, best.moves, options.compact, best.bound <= 1);
+            cout << "Suboptimality bound: " << best.bound << endl;
+        }
+        else
+            cout << "no solution before the deadline" << endl;
+        cout << "Explored node: " << solver.explored_node << endl;
+        cout << "Expanded node: " << solver.expanded_node << endl;
+        return 0;
+    }
+
+    if (options.mode == "disk")
+    {
+        disk_search_solver<W, heuristic> solver(options.directory, options.memory_mb << 20);
+        vector<int> moves;
+        bool solved = solver.solve(node, moves);
+        if (solver.resumed)
+            cout << "resumed from checkpoint" << endl;
+        if (solved)
+        {
+            cout << "solved" << endl;
+            print_solution(node, moves, options.compact);
+        }
+        else
+            cout << "no solution" << endl;
+        cout << "Explored node: " << solver.explored_node << endl;
+        cout << "Expanded node: " << solver.expanded_node << endl;
+        cout << "Bytes written: " << solver.bytes_written << endl;
+        return 0;
+    }
+
+    if (options.mode == "bidir")
+    {
+        solve_bidirectional<W, heuristic>(node, options);
+        return 0;
+    }
+
+    if (options.mode == "epea")
+    {
+        epea_star_solver<W, heuristic> solver;
+        vector<int> moves;
+        auto start = chrono::steady_clock::now();
+        bool solved = solver.solve(node, moves);
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        cout << (solved ? "solved" : "no solution") << endl;
+        if (solved)
+            print_solution(node, moves, options.compact);
+        cout << "Explored node: " << solver.explored_node << endl;
+        cout << "Expanded node: " << solver.expanded_node << " (" << solver.reinserted_node << " put back)" << endl;
+        cout << "Peak bytes: " << solver.peak_bytes() << ", " << ms << " ms" << endl;
+
+        astar_solver<W, heuristic> full;
+        vector<int> full_moves;
+        start = chrono::steady_clock::now();
+        full.solve(node, full_moves);
+        ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        cout << "A* explored node: " << full.explored_node << endl;
+        cout << "A* expanded node: " << full.expanded_node << endl;
+        cout << "A* peak bytes: " << full.peak_bytes() << ", " << ms << " ms" << endl;
+        return 0;
+    }
+
+    if (options.mode == "hda")
+    {
+        hda_star_solver<W, heuristic> solver(options.threads);
+        const hda_node<W> *correct_config = solver.solve(node);
+        cout << (correct_config != nullptr ? "solved" : "no solution") << endl;
+        if (correct_config != nullptr)
+            print_solution(node, parent_moves(correct_config), options.compact);
+        cout << "Explored node: " << solver.explored_node << endl;
+        cout << "Expanded node: " << solver.expanded_node << endl;
+        for (size_t i = 0; i < solver.thread_expanded.size(); i++)
+        {
+            cout << "Thread " << i << " expanded node: " << solver.thread_expanded[i] << " ("
+                 << 100.0 * solver.thread_expanded[i] / max(1LL, solver.expanded_node) << "%)" << endl;
+        }
+        return 0;
+    }
+
+    astar_solver<W, heuristic> solver;
+    vector<int> moves;
+    bool solved = solver.solve(node, moves);
+    cout << (solved ? "solved" : "no solution") << endl;
+    if (solved)
+        print_solution(node, moves, options.compact);
+    cout << "Explored node: " << solver.explored_node << endl;
+    cout << "Expanded node: " << solver.expanded_node << endl;
+    cout << "Reopened node: " << solver.reopened_node << endl;
+    const auto &closed = solver.closed();
+    cout << "Closed table: " << closed.size() << " states, load factor " << closed.load_factor()
+         << ", mean probe " << closed.mean_probe_length() << " groups, max probe "
+         << closed.max_probe_length() << " groups" << endl;
+    // JSON instrumentation report, only in -DSEARCH_STATS builds
+    solver.stats.write_json(cerr, heuristic::name, solver.expanded_node, solver.explored_node);
+    return 0;
+}
+
+template <int W>
+int run(int argc, char *argv[])
+{
+    search_node<W> node;
+    if (!node.read(cin))
+    {
+        cout << "Invalid board" << endl;
+        return 0;
+    }
+    if (argc < 2)
+    {
+        cout << "Missing arguement" << endl;
+        return 0;
+    }
+    // optional search mode after the heuristic: astar (default), ida,
+    // pida [threads], hda [threads], bidir, epea, disk [directory] [memory MB],
+    // anytime [deadline ms] [weight] or, for 3x3 only, table (the default
+    // there); a last argument of udlr prints the solution as a move string
+    solve_options options;
+    if (argc > 2 && string(argv[argc - 1]) == "udlr")
+    {
+        options.compact = true;
+        argc--;
+    }
+    if (argc > 2)
+        options.mode = argv[2];
+    else if (W == 3)
+        options.mode = "table";
+    if (options.mode == "table")
+    {
+        if (W != 3)
+        {
+            cout << "The distance table only covers 3x3 boards" << endl;
+            return 0;
+        }
+        if (!eight_puzzle_table.load())
+            options.mode = "astar";
+    }
+    if (options.mode == "hda" || options.mode == "pida")
+        options.threads = argc > 3 ? atoi(argv[3]) : max(1u, thread::hardware_concurrency());
+    if (options.mode == "anytime")
+    {
+        if (argc > 3)
+            options.deadline_ms = atof(argv[3]);
+        if (argc > 4)
+            options.weight = atof(argv[4]);
+    }
+    if (options.mode == "disk")
+    {
+        if (argc > 3)
+            options.directory = argv[3];
+        if (argc > 4 && atoi(argv[4]) > 0)
+            options.memory_mb = atoi(argv[4]);
+    }
+
+    switch (argv[1][0])
+    {
+    case '2':
+        return solve_puzzle<W, manhattan_distane<W>>(node, options);
+    case '3':
+        return solve_puzzle<W, euclidean_distance<W>>(node, options);
+    case '4':
+        return solve_puzzle<W, linear_conflict<W>>(node, options);
+    case '5':
+        if (!pattern_databases[W].load(W))
+        {
+            cout << "No pattern database for this board size" << endl;
+            return 0;
+        }
+        return solve_puzzle<W, pattern_database_distance<W>>(node, options);
+    case '6':
+        if (!walking_distance_tables[W].build(W))
+        {
+            cout << "No walking distance table for this board size" << endl;
+            return 0;
+        }
+        return solve_puzzle<W, walking_distance<W>>(node, options);
+    case '1':
+    default:
+        return solve_puzzle<W, hamming_distance<W>>(node, options);
+    }
+}
+
+// ./a.out <heuristic> batch <file|-> [threads] [astar|epea|ida|pida|hda|bidir|disk|table] [csv|json]
+int batch(int argc, char *argv[])
+{
+    batch_options options;
+    options.threads = max(1u, thread::hardware_concurrency());
+    string path = argc > 3 ? argv[3] : "-";
+    for (int i = 4; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "astar" || arg == "epea" || arg == "ida" || arg == "pida" || arg == "hda" || arg == "bidir" || arg == "disk" || arg == "table")
+            options.engine = arg;
+        else if (arg == "csv" || arg == "json")
+            options.format = arg;
+        else if (atoi(argv[i]) > 0)
+            options.threads = atoi(argv[i]);
+    }
+
+    vector<batch_instance> instances;
+    ifstream file;
+    if (path != "-")
+    {
+        file.open(path);
+        if (!file)
+        {
+            cout << "Cannot open " << path << endl;
+            return 0;
+        }
+    }
+    if (!read_batch_instances(path == "-" ? cin : file, instances))
+    {
+        cout << "Invalid board" << endl;
+        return 0;
+    }
+    if (options.engine == "table" && !eight_puzzle_table.load())
+        options.engine = "astar";
+
+    switch (argv[1][0])
+    {
+    case '2':
+        run_batch<manhattan_distane>(instances, options);
+        break;
+    case '3':
+        run_batch<euclidean_distance>(instances, options);
+        break;
+    case '4':
+        run_batch<linear_conflict>(instances, options);
+        break;
+    case '5':
+        // tables are loaded up front: workers only read them
+        for (const batch_instance &instance : instances)
+        {
+            if (pattern_databases[instance.size].patterns.empty() &&
+                !pattern_databases[instance.size].load(instance.size))
+            {
+                cout << "No pattern database for this board size" << endl;
+                return 0;
+            }
+        }
+        run_batch<pattern_database_distance>(instances, options);
+        break;
+    case '6':
+        for (const batch_instance &instance : instances)
+        {
+            if (!walking_distance_tables[instance.size].build(instance.size))
+            {
+                cout << "No walking distance table for this board size" << endl;
+                return 0;
+            }
+        }
+        run_batch<walking_distance>(instances, options);
+        break;
+    case '1':
+    default:
+        run_batch<hamming_distance>(instances, options);
+        break;
+    }
+    return 0;
+}
+
+// ./a.out <heuristic> serve [socket path|-] [cache entries] [astar|ida]
+int serve(int argc, char *argv[])
+{
+    daemon_options options;
+    for (int i = 3; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "astar" || arg == "ida")
+            options.engine = arg;
+        else if (atoll(argv[i]) > 0)
+            options.cache_entries = atoll(argv[i]);
+        else if (arg != "-")
+            options.socket_path = arg;
+    }
+    auto run_daemon = [&](auto &daemon)
+    {
+        return options.socket_path.empty() ? daemon.serve(cin, cout) : daemon.serve(options.socket_path);
+    };
+    switch (argv[1][0])
+    {
+    case '2':
+    {
+        solver_daemon<manhattan_distane> daemon(options);
+        return run_daemon(daemon);
+    }
+    case '3':
+    {
+        solver_daemon<euclidean_distance> daemon(options);
+        return run_daemon(daemon);
+    }
+    case '4':
+    {
+        solver_daemon<linear_conflict> daemon(options);
+        return run_daemon(daemon);
+    }
+    case '5':
+    {
+        solver_daemon<pattern_database_distance> daemon(options);
+        return run_daemon(daemon);
+    }
+    case '6':
+    {
+        solver_daemon<walking_distance> daemon(options);
+        return run_daemon(daemon);
+    }
+    case '1':
+    default:
+    {
+        solver_daemon<hamming_distance> daemon(options);
+        return run_daemon(daemon);
+    }
+    }
+}
+
+// ./a.out build-pdb <n> [threads] [checkpoint directory]
+int build_pdb(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        cout << "Missing arguement" << endl;
+        return 0;
+    }
+    int n = atoi(argv[2]);
+    pdb_build_options options;
+    options.threads = argc > 3 && atoi(argv[3]) > 0 ? atoi(argv[3]) : max(1u, thread::hardware_concurrency());
+    if (argc > 4)
+        options.checkpoint_directory = argv[4];
+    auto start = chrono::steady_clock::now();
+    if (n < 2 || n > MAX_PACKED_SIZE || !build_pattern_databases(n, options))
+    {
+        cout << "No pattern database for this board size" << endl;
+        return 1;
+    }
+    cout << "Pattern databases for " << n << "x" << n << " ready in "
+         << chrono::duration<double>(chrono::steady_clock::now() - start).count() << " s" << endl;
+    return 0;
+}
+
+// ./a.out realtime [move budget in microseconds], then the board on stdin;
+// any size from 3x3 up. Move latency is measured, and moves slower than
+// the budget are counted, not prevented.
+int realtime(int argc, char *argv[])
+{
+    int n;
+    if (!(cin >> n) || n < 3)
+    {
+        cout << "Board size not supported" << endl;
+        return 0;
+    }
+    realtime_solver solver(n);
+    if (!solver.read(cin))
+    {
+        cout << "Invalid board" << endl;
+        return 0;
+    }
+    double budget_us = argc > 2 ? atof(argv[2]) : 0;
+    cout << "Search algorithm: real-time line reduction" << endl;
+    if (!solver.solvable())
+    {
+        cout << "not solvable" << endl;
+        return 0;
+    }
+    if (!eight_puzzle_table.load())
+        return 1;
+
+    vector<int> moves;
+    double total_us = 0, max_us = 0;
+    long long over_budget = 0;
+    while (true)
+    {
+        auto start = chrono::steady_clock::now();
+        int move = solver.step();
+        double us = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+        total_us += us;
+        max_us = max(max_us, us);
+        if (budget_us > 0 && us > budget_us)
+            over_budget++;
+        if (move < 0)
+            break;
+        moves.push_back(move);
+    }
+    if (solver.failed || !solver.solved())
+    {
+        cout << "no solution" << endl;
+        return 1;
+    }
+    cout << "solved" << endl;
+    cout << "Number of moves = " << moves.size() << endl;
+    for (int move : moves)
+        cout << "UDLR"[move];
+    cout << endl;
+    cout << "Total: " << total_us / 1000 << " ms, move latency max " << max_us << " us, mean "
+         << total_us / (moves.size() + 1) << " us" << endl;
+    if (budget_us > 0)
+        cout << "Moves over the " << budget_us << " us budget (measured, not enforced): " << over_budget << endl;
+    return 0;
+}
+
+// ./a.out generate <n> <count> <walk length|random> [seed]
+int generate(int argc, char *argv[])
+{
+    if (argc < 5)
+    {
+        cout << "Missing arguement" << endl;
+        return 0;
+    }
+    int n = atoi(argv[2]);
+    int count = atoi(argv[3]);
+    int walk_length = string(argv[4]) == "random" ? 0 : atoi(argv[4]);
+    uint64_t seed = argc > 5 ? strtoull(argv[5], nullptr, 10) : 318;
+    bool ok;
+    switch (n)
+    {
+    case 2:
+        ok = generate_benchmark<2>(cout, count, walk_length, seed);
+        break;
+    case 3:
+        ok = generate_benchmark<3>(cout, count, walk_length, seed);
+        break;
+    case 4:
+        ok = generate_benchmark<4>(cout, count, walk_length, seed);
+        break;
+    case 5:
+        ok = generate_benchmark<5>(cout, count, walk_length, seed);
+        break;
+    case 6:
+        ok = generate_benchmark<6>(cout, count, walk_length, seed);
+        break;
+    case 7:
+        ok = generate_benchmark<7>(cout, count, walk_length, seed);
+        break;
+    case 8:
+        ok = generate_benchmark<8>(cout, count, walk_length, seed);
+        break;
+    default:
+        cout << "Board size not supported" << endl;
+        return 0;
+    }
+    if (!ok)
+        cerr << "generated an unsolvable instance" << endl;
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && string(argv[1]) == "generate")
+        return generate(argc, argv);
+    if (argc > 1 && string(argv[1]) == "build-pdb")
+        return build_pdb(argc, argv);
+    if (argc > 1 && string(argv[1]) == "realtime")
+        return realtime(argc, argv);
+    if (argc > 2 && string(argv[2]) == "batch")
+        return batch(argc, argv);
+    if (argc > 2 && string(argv[2]) == "serve")
+        return serve(argc, argv);
+
+    int n;
+    cin >> n;
+    // one instantiation per board width, so every board loop has a
+    // compile-time bound
+    switch (n)
+    {
+    case 2:
+        return run<2>(argc, argv);
+    case 3:
+        return run<3>(argc, argv);
+    case 4:
+        return run<4>(argc, argv);
+    case 5:
+        return run<5>(argc, argv);
+    case 6:
+        return run<6>(argc, argv);
+    case 7:
+        return run<7>(argc, argv);
+    case 8:
+        return run<8>(argc, argv);
+    default:
+        cout << "Board size not supported" << endl;
+        return 0;
+    }
+}
@@ -0,0 +1,261 @@
+#ifndef ANYTIME_ASTAR_H
+#define ANYTIME_ASTAR_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <queue>
+#include <vector>
+#include "closed_table.h"
+#include "node_pool.h"
+#include "path_store.h"
+#include "search_node.h"
+
+// Anytime repairing A* (ARA*, Likhachev et al.). Search starts with the
+// priority g + weight * h, which finds a path quickly, then lowers the
+// weight and continues from the same nodes instead of starting over: only
+// nodes whose g improved since they were expanded (kept in an
+// inconsistent list) go back on the open list. Every search iteration
+// publishes its path with the bound
+// min(weight, cost / min over open and inconsistent nodes of g + h),
+// so the last path returned before the deadline is within that factor of
+// optimal; a bound of 1 proves it optimal.
+
+template <int W>
+struct anytime_node : search_node<W>
+{
+    int closed_iteration = -1; // iteration the node was last expanded in
+    bool inconsistent = false;
+};
+
+struct anytime_solution
+{
+    std::vector<int> moves;
+    double cost = INFINITY;
+    double weight = 0;
+    double bound = INFINITY;
+    double ms = 0;
+    long long expanded = 0;
+};
+
+template <int W, class heuristic>
+class anytime_astar_solver
+{
+public:
+    typedef anytime_node<W> node_type;
+
+    long long explored_node = 0;
+    long long expanded_node = 0;
+    std::vector<anytime_solution> solutions; // in the order they were found
+
+    anytime_astar_solver(double initial_weight_ = 3, double weight_step_ = 0.5)
+        : initial_weight(std::max(1.0, initial_weight_)), weight_step(weight_step_)
+    {
+    }
+
+    // Returns false if no path was found before the deadline; otherwise the
+    // last entry of solutions is the best path.
+    bool solve(const search_node<W> &start, double deadline_ms)
+    {
+        begin = std::chrono::steady_clock::now();
+        deadline = begin + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                               std::chrono::duration<double, std::milli>(deadline_ms));
+        correct_configuration = goal_state<W>();
+
+        node_type *root = node_arena.scratch(node_type());
+        static_cast<search_node<W> &>(*root) = start;
+        root->path_index = path_store::root;
+        root->g_n = 0;
+        evaluate<W, heuristic>(*root);
+        node_arena.commit();
+        bool inserted;
+        typename closed_table<W, node_type>::slot &entry = closed_list.find_or_insert(root->board, inserted);
+        entry.g_n = 0;
+        entry.node = root;
+        explored_node++;
+
+        weight = initial_weight;
+        if (root->board == correct_configuration)
+            goal = root;
+        push(root);
+        for (iteration = 0;; iteration++)
+        {
+            if (!improve_path())
+                break; // out of time
+            if (goal != nullptr)
+                publish();
+            if (weight <= 1 || (goal != nullptr && solutions.back().bound <= 1))
+                break;
+            weight = std::max(1.0, weight - weight_step);
+            reopen();
+        }
+        return !solutions.empty();
+    }
+
+private:
+    struct entry
+    {
+        double key;
+        double g_n;
+        node_type *node;
+        // with std::greater: lowest key first, ties to the deeper entry as
+        // in the bucket queue
+        bool operator>(const entry &other) const
+        {
+            return key != other.key ? key > other.key : g_n < other.g_n;
+        }
+    };
+
+    double initial_weight;
+    double weight_step;
+    double weight = 1;
+    int iteration = 0;
+    std::chrono::steady_clock::time_point begin, deadline;
+    packed_state<W> correct_configuration;
+    const node_type *goal = nullptr;
+
+    closed_table<W, node_type> closed_list;
+    node_pool<node_type> node_arena;
+    path_store paths;
+    std::priority_queue<entry, std::vector<entry>, std::greater<entry>> open_list;
+    std::vector<node_type *> inconsistent_list;
+
+    void push(node_type *node)
+    {
+        open_list.push({node->g_n + weight * node->h_n, node->g_n, node});
+    }
+
+    // Entries left behind by a later g improvement or an expansion in this
+    // iteration are skipped.
+    bool stale(const entry &top) const
+    {
+        return top.g_n != top.node->g_n || top.node->closed_iteration == iteration;
+    }
+
+    // Expands until no open node could beat the goal's weighted priority.
+    // False when the deadline passes first.
+    bool improve_path()
+    {
+        while (!open_list.empty())
+        {
+            entry top = open_list.top();
+            if (stale(top))
+            {
+                open_list.pop();
+                continue;
+            }
+            if (goal != nullptr && goal->g_n <= top.key)
+                return true;
+            open_list.pop();
+            node_type *node = top.node;
+            node->closed_iteration = iteration;
+            expanded_node++;
+            if ((expanded_node & 1023) == 0 && std::chrono::steady_clock::now() >= deadline)
+                return false;
+            if (node->board == correct_configuration)
+                continue; // nothing beyond the goal can shorten the path to it
+            generate_children(*node);
+        }
+        return true;
+    }
+
+    void generate_children(node_type &node)
+    {
+        for (int move = 0; move < MOVE_COUNT; move++)
+        {
+            int target = tables<W>.move_target[node.blank][move];
+            if (target < 0)
+                continue;
+            node_type *child = node_arena.scratch(node);
+            child->closed_iteration = -1;
+            child->inconsistent = false;
+            move_blank<W, heuristic>(*child, target);
+            bool inserted;
+            typename closed_table<W, node_type>::slot &slot = closed_list.find_or_insert(child->board, inserted);
+            if (slot.g_n <= child->g_n)
+                continue;
+            slot.g_n = child->g_n;
+            child->path_index = paths.add(node.path_index, move);
+            if (inserted)
+            {
+                node_arena.commit();
+                slot.node = child;
+                explored_node++;
+            }
+            else
+            {
+                // the state keeps its node; only g, f and the path change
+                node_type *known = slot.node;
+                known->g_n = child->g_n;
+                known->priority_value = child->priority_value;
+                known->path_index = child->path_index;
+                child = known;
+            }
+            if (child->board == correct_configuration)
+                goal = child;
+            if (child->closed_iteration == iteration)
+            {
+                if (!child->inconsistent)
+                {
+                    child->inconsistent = true;
+                    inconsistent_list.push_back(child);
+                }
+            }
+            else
+                push(child);
+        }
+    }
+
+    // New weight: the inconsistent nodes join the open ones and every key
+    // is recomputed. Nothing counts as closed in the next iteration.
+    void reopen()
+    {
+        std::vector<node_type *> open_nodes;
+        for (; !open_list.empty(); open_list.pop())
+        {
+            const entry &top = open_list.top();
+            if (!stale(top))
+                open_nodes.push_back(top.node);
+        }
+        for (node_type *node : inconsistent_list)
+        {
+            node->inconsistent = false;
+            open_nodes.push_back(node);
+        }
+        inconsistent_list.clear();
+        for (node_type *node : open_nodes)
+            push(node);
+    }
+
+    void publish()
+    {
+        anytime_solution solution;
+        solution.cost = goal->g_n;
+        solution.weight = weight;
+        solution.expanded = expanded_node;
+        solution.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+        // lower bound on the optimal cost from everything not yet settled
+        double lower = goal->g_n;
+        std::vector<entry> kept;
+        for (; !open_list.empty(); open_list.pop())
+        {
+            const entry &top = open_list.top();
+            if (stale(top))
+                continue;
+            lower = std::min(lower, top.node->priority_value);
+            kept.push_back(top);
+        }
+        for (const entry &e : kept)
+            open_list.push(e);
+        for (const node_type *node : inconsistent_list)
+            lower = std::min(lower, node->priority_value);
+        solution.bound = lower > 0 ? std::min(weight, goal->g_n / lower) : 1;
+
+        solution.moves = paths.moves(goal->path_index);
+        if (solutions.empty() || solution.cost < solutions.back().cost || solution.bound < solutions.back().bound)
+            solutions.push_back(solution);
+    }
+};
+
+#endif
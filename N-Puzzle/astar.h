@@ -0,0 +1,222 @@
+#ifndef ASTAR_H
+#define ASTAR_H
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <queue>
+#include <vector>
+#include "bucket_queue.h"
+#include "closed_table.h"
+#include "distance_cache.h"
+#include "node_pool.h"
+#include "path_store.h"
+#include "search_node.h"
+#include "search_stats.h"
+
+template <class node_type>
+struct ComparePriority
+{
+    bool operator()(node_type *const &n1,
+                    node_type *const &n2) const
+    {
+        if (n1->priority_value == n2->priority_value)
+        {
+            return n1->h_n > n2->h_n;
+        }
+        return n1->priority_value > n2->priority_value;
+    }
+};
+
+// Integer heuristics use the bucket queue; Euclidean distance produces
+// fractional f values and stays on the binary heap.
+template <class node_type, bool integer_priorities>
+class open_list_queue
+{
+public:
+    void push(node_type *node)
+    {
+        if constexpr (integer_priorities)
+            buckets.push(node, lround(node->priority_value), lround(node->h_n));
+        else
+            heap.push(node);
+    }
+    node_type *top()
+    {
+        if constexpr (integer_priorities)
+            return buckets.top();
+        else
+            return heap.top();
+    }
+    void pop()
+    {
+        if constexpr (integer_priorities)
+            buckets.pop();
+        else
+            heap.pop();
+    }
+    bool empty() const
+    {
+        return integer_priorities ? buckets.empty() : heap.empty();
+    }
+    size_t size() const
+    {
+        return integer_priorities ? buckets.size() : heap.size();
+    }
+
+private:
+    bucket_queue<node_type> buckets;
+    std::priority_queue<node_type *, std::vector<node_type *>, ComparePriority<node_type>> heap;
+};
+
+template <int W, class heuristic>
+class astar_solver
+{
+public:
+    typedef search_node<W> node_type;
+
+    long long explored_node = 0;
+    long long expanded_node = 0;
+    long long reopened_node = 0;
+    search_stats stats; // empty unless built with -DSEARCH_STATS
+    long long cache_cutoffs = 0;
+
+    // Optional exact distances (the solver daemon's cache). A cached board
+    // gets f = g + its distance, and popping one ends the search with the
+    // cached rest of its path: no open node has a lower f, so no path is
+    // shorter. The raised f makes h inconsistent, which reopening absorbs.
+    distance_cache<W> *exact = nullptr;
+
+    // Fills path with the blank moves from start to the goal. A node is
+    // recycled once expanded (or skipped as stale); what stays per state is
+    // its closed table slot and a path record.
+    bool solve(const node_type &start, std::vector<int> &path)
+    {
+        const packed_state<W> correct_configuration = goal_state<W>();
+        stats.start();
+        path.clear();
+        paths.clear();
+        node_type *root = node_arena.scratch(start);
+        root->path_index = path_store::root;
+        root->g_n = 0;
+        evaluate<W, heuristic>(*root);
+        raise_to_exact(*root);
+        node_arena.commit();
+        open_list.push(root);
+        explored_node++;
+        bool inserted;
+        typename closed_table<W, node_type>::slot &entry = closed_list.find_or_insert(root->board, inserted);
+        entry.g_n = 0;
+        entry.node = root;
+
+        while (!open_list.empty())
+        {
+            node_type *promising_node;
+            {
+                phase_timer timer(stats, PHASE_QUEUE);
+                promising_node = open_list.top();
+                open_list.pop();
+            }
+            {
+                phase_timer timer(stats, PHASE_HASH);
+                typename closed_table<W, node_type>::slot *closed = closed_list.find(promising_node->board);
+                if (closed->node != promising_node)
+                {
+                    node_arena.recycle(promising_node); // re-opened later with a lower g
+                    continue;
+                }
+                closed->node = nullptr;
+            }
+            expanded_node++;
+            stats.expansion(expanded_node, promising_node->priority_value, open_list.size(), closed_list.size());
+            if (promising_node->board == correct_configuration)
+            {
+                path = paths.moves(promising_node->path_index);
+                return true;
+            }
+            if (exact != nullptr && exact->peek(promising_node->board) >= 0)
+            {
+                path = paths.moves(promising_node->path_index);
+                if (exact->follow(*promising_node, path))
+                {
+                    cache_cutoffs++;
+                    return true;
+                }
+            }
+            {
+                phase_timer timer(stats, PHASE_EXPAND);
+                generate_children(*promising_node);
+            }
+            node_arena.recycle(promising_node);
+            peak_open = std::max(peak_open, open_list.size());
+        }
+        return false;
+    }
+
+    // Bytes held by the search at its largest: node slabs, the closed
+    // table, path records and open list slots.
+    size_t peak_bytes() const
+    {
+        return node_arena.allocated_bytes() + closed_list.bytes() + paths.bytes() +
+               peak_open * sizeof(node_type *);
+    }
+
+    const closed_table<W, node_type> &closed() const
+    {
+        return closed_list;
+    }
+
+private:
+    closed_table<W, node_type> closed_list;
+    open_list_queue<node_type, heuristic::integer> open_list;
+    node_pool<node_type> node_arena;
+    path_store paths;
+    size_t peak_open = 0;
+
+    void raise_to_exact(node_type &node) const
+    {
+        if (exact == nullptr)
+            return;
+        int distance = exact->peek(node.board);
+        if (distance > node.h_n)
+            node.priority_value = node.g_n + distance;
+    }
+
+    void generate_children(node_type &node)
+    {
+        for (int move = 0; move < MOVE_COUNT; move++)
+        {
+            int target = tables<W>.move_target[node.blank][move];
+            if (target < 0)
+                continue;
+            node_type *child = node_arena.scratch(node);
+            {
+                phase_timer timer(stats, PHASE_HEURISTIC);
+                move_blank<W, heuristic>(*child, target);
+                raise_to_exact(*child);
+            }
+            bool inserted;
+            typename closed_table<W, node_type>::slot *entry;
+            {
+                phase_timer timer(stats, PHASE_HASH);
+                entry = &closed_list.find_or_insert(child->board, inserted);
+            }
+            if (entry->g_n <= child->g_n)
+                continue; // a duplicate stays in the scratch slot and is overwritten by the next child
+            if (!inserted && entry->node == nullptr)
+                reopened_node++; // closed, now re-opened with a lower g
+            // a copy still queued is skipped when popped
+            entry->g_n = child->g_n;
+            entry->node = child;
+            child->path_index = paths.add(node.path_index, move);
+            node_arena.commit();
+            {
+                phase_timer timer(stats, PHASE_QUEUE);
+                open_list.push(child);
+            }
+            explored_node++;
+        }
+    }
+};
+
+#endif
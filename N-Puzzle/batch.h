@@ -0,0 +1,309 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "astar.h"
+#include "bidirectional.h"
+#include "disk_search.h"
+#include "distance_table.h"
+#include "epea_star.h"
+#include "hda_star.h"
+#include "ida_star.h"
+#include "parallel_ida_star.h"
+#include "search_node.h"
+
+// Batch solving: a file of instances (n followed by the n x n board, the
+// same format main reads, repeated) is spread over a pool of threads. Each
+// instance gets its own solver object, so workers share nothing but the
+// read-only heuristic tables, and one CSV or JSON line is written per
+// instance as it finishes. Every solving mode can be batched; HDA* runs the
+// instances one at a time with all the threads on each.
+
+struct batch_instance
+{
+    int size = 0;
+    std::vector<int> tiles;
+};
+
+struct batch_result
+{
+    size_t index = 0;
+    int size = 0;
+    bool solvable = false;
+    int moves = -1;
+    long long expanded = 0;
+    long long explored = 0;
+    double ms = 0;
+    size_t peak_bytes = 0;
+};
+
+struct batch_options
+{
+    std::string engine = "astar"; // astar, epea, ida, pida, hda, bidir, disk or table (3x3; A* for other sizes)
+    std::string format = "csv";   // csv or json
+    int threads = 1;
+    std::string directory = DISK_SEARCH_DIRECTORY; // disk mode, one subdirectory per instance
+    size_t memory_mb = 256;                         // disk mode, per worker
+};
+
+inline bool read_batch_instances(std::istream &in, std::vector<batch_instance> &instances)
+{
+    int n;
+    while (in >> n)
+    {
+        if (n < 2 || n > MAX_PACKED_SIZE)
+            return false;
+        batch_instance instance;
+        instance.size = n;
+        instance.tiles.resize(n * n);
+        for (int &tile : instance.tiles)
+        {
+            if (!(in >> tile))
+                return false;
+        }
+        if (!is_board_permutation(instance.tiles, n * n))
+            return false;
+        instances.push_back(instance);
+    }
+    return in.eof();
+}
+
+template <int W, class heuristic>
+batch_result solve_batch_instance(const batch_instance &instance, size_t index, const batch_options &options)
+{
+    batch_result result;
+    result.index = index;
+    result.size = W;
+    search_node<W> node;
+    for (int cell = 0; cell < W * W; cell++)
+    {
+        node.board.set(cell, instance.tiles[cell]);
+        if (instance.tiles[cell] == 0)
+            node.blank = cell;
+    }
+    result.solvable = solvable(node);
+    if (!result.solvable)
+        return result;
+
+    auto start = std::chrono::steady_clock::now();
+    if (W == 3 && options.engine == "table")
+    {
+        std::vector<int> moves;
+        if (solve_with_distance_table(node, moves, result.explored))
+            result.moves = moves.size();
+        result.expanded = result.moves;
+    }
+    else if (options.engine == "ida")
+    {
+        ida_star_solver<W, heuristic> solver;
+        std::vector<int> moves;
+        if (solver.solve(node, moves))
+            result.moves = moves.size();
+        result.expanded = solver.expanded_node;
+        result.explored = solver.explored_node;
+        result.peak_bytes = solver.peak_bytes(moves);
+    }
+    else if (options.engine == "epea")
+    {
+        epea_star_solver<W, heuristic> solver;
+        std::vector<int> moves;
+        if (solver.solve(node, moves))
+            result.moves = moves.size();
+        result.expanded = solver.expanded_node;
+        result.explored = solver.explored_node;
+        result.peak_bytes = solver.peak_bytes();
+    }
+    else if (options.engine == "pida")
+    {
+        parallel_ida_star_solver<W, heuristic> solver(options.threads);
+        std::vector<int> moves;
+        if (solver.solve(node, moves))
+            result.moves = moves.size();
+        result.expanded = solver.expanded_node;
+        result.explored = solver.explored_node;
+        result.peak_bytes = solver.peak_bytes();
+    }
+    else if (options.engine == "hda")
+    {
+        hda_star_solver<W, heuristic> solver(options.threads);
+        const hda_node<W> *correct_config = solver.solve(node);
+        if (correct_config != nullptr)
+            result.moves = lround(correct_config->g_n);
+        result.expanded = solver.expanded_node;
+        result.explored = solver.explored_node;
+        result.peak_bytes = solver.peak_bytes();
+    }
+    else if (options.engine == "bidir")
+    {
+        if constexpr (heuristic::retargetable)
+        {
+            bidirectional_solver<W, heuristic> solver;
+            std::vector<int> moves;
+            if (solver.solve(node, moves))
+                result.moves = moves.size();
+            result.expanded = solver.expanded_node;
+            result.explored = solver.explored_node;
+            result.peak_bytes = solver.peak_bytes();
+        }
+    }
+    else if (options.engine == "disk")
+    {
+        disk_search_solver<W, heuristic> solver(options.directory + "/" + std::to_string(index),
+                                                options.memory_mb << 20);
+        std::vector<int> moves;
+        if (solver.solve(node, moves))
+            result.moves = moves.size();
+        result.expanded = solver.expanded_node;
+        result.explored = solver.explored_node;
+        result.peak_bytes = solver.peak_bytes();
+        rmdir((options.directory + "/" + std::to_string(index)).c_str());
+    }
+    else
+    {
+        astar_solver<W, heuristic> solver;
+        std::vector<int> moves;
+        if (solver.solve(node, moves))
+            result.moves = moves.size();
+        result.expanded = solver.expanded_node;
+        result.explored = solver.explored_node;
+        result.peak_bytes = solver.peak_bytes();
+    }
+    result.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+// heuristic is one of the policy templates from heuristics.h
+template <template <int> class heuristic>
+batch_result solve_batch_instance(const batch_instance &instance, size_t index, const batch_options &options)
+{
+    switch (instance.size)
+    {
+    case 2:
+        return solve_batch_instance<2, heuristic<2>>(instance, index, options);
+    case 3:
+        return solve_batch_instance<3, heuristic<3>>(instance, index, options);
+    case 4:
+        return solve_batch_instance<4, heuristic<4>>(instance, index, options);
+    case 5:
+        return solve_batch_instance<5, heuristic<5>>(instance, index, options);
+    case 6:
+        return solve_batch_instance<6, heuristic<6>>(instance, index, options);
+    case 7:
+        return solve_batch_instance<7, heuristic<7>>(instance, index, options);
+    default:
+        return solve_batch_instance<8, heuristic<8>>(instance, index, options);
+    }
+}
+
+inline void write_batch_result(std::ostream &out, const batch_result &result, const std::string &format)
+{
+    char line[256];
+    if (format == "json")
+        snprintf(line, sizeof(line),
+                 "{\"index\": %zu, \"size\": %d, \"solvable\": %s, \"moves\": %d, \"expanded\": %lld, "
+                 "\"explored\": %lld, \"ms\": %.3f, \"peak_bytes\": %zu}",
+                 result.index, result.size, result.solvable ? "true" : "false", result.moves,
+                 result.expanded, result.explored, result.ms, result.peak_bytes);
+    else
+        snprintf(line, sizeof(line), "%zu,%d,%d,%d,%lld,%lld,%.3f,%zu",
+                 result.index, result.size, int(result.solvable), result.moves,
+                 result.expanded, result.explored, result.ms, result.peak_bytes);
+    out << line << '\n';
+}
+
+// Nearest-rank percentile of an ascending list.
+inline double percentile(const std::vector<double> &sorted, double p)
+{
+    if (sorted.empty())
+        return 0;
+    size_t rank = size_t(p / 100 * sorted.size() + 0.999999);
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+inline void write_batch_summary(std::ostream &out, const std::vector<batch_result> &results,
+                                double wall_ms, const batch_options &options)
+{
+    std::vector<double> latency;
+    long long expanded = 0;
+    size_t solved = 0;
+    size_t peak_bytes = 0;
+    for (const batch_result &result : results)
+    {
+        expanded += result.expanded;
+        peak_bytes = std::max(peak_bytes, result.peak_bytes);
+        solved += result.moves >= 0;
+        if (result.solvable)
+            latency.push_back(result.ms);
+    }
+    std::sort(latency.begin(), latency.end());
+    double seconds = wall_ms / 1000;
+
+    char line[512];
+    snprintf(line, sizeof(line),
+             "\"instances\": %zu, \"solved\": %zu, \"threads\": %d, \"wall_ms\": %.3f, "
+             "\"expanded\": %lld, \"instances_per_sec\": %.2f, \"expanded_per_sec\": %.0f, "
+             "\"p50_ms\": %.3f, \"p90_ms\": %.3f, \"p99_ms\": %.3f, \"max_ms\": %.3f, \"max_peak_bytes\": %zu",
+             results.size(), solved, options.threads, wall_ms, expanded,
+             seconds > 0 ? results.size() / seconds : 0, seconds > 0 ? expanded / seconds : 0,
+             percentile(latency, 50), percentile(latency, 90), percentile(latency, 99),
+             latency.empty() ? 0 : latency.back(), peak_bytes);
+    if (options.format == "json")
+        out << "{\"summary\": {" << line << "}}" << '\n';
+    else
+        out << "# summary: {" << line << "}" << '\n';
+}
+
+template <template <int> class heuristic>
+void run_batch(const std::vector<batch_instance> &instances, const batch_options &options)
+{
+    if (options.engine == "bidir" && !heuristic<4>::retargetable)
+    {
+        std::cout << "This heuristic cannot measure distances to the start board" << std::endl;
+        return;
+    }
+    std::vector<batch_result> results(instances.size());
+    std::atomic<size_t> next_instance{0};
+    std::mutex output_mutex;
+
+    if (options.format != "json")
+        std::cout << "index,size,solvable,moves,expanded,explored,ms,peak_bytes" << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    auto work = [&]()
+    {
+        size_t index;
+        while ((index = next_instance++) < instances.size())
+        {
+            batch_result result = solve_batch_instance<heuristic>(instances[index], index, options);
+            results[index] = result;
+            std::lock_guard<std::mutex> lock(output_mutex);
+            write_batch_result(std::cout, result, options.format);
+        }
+    };
+    std::vector<std::thread> threads;
+    if (options.engine == "disk")
+        mkdir(options.directory.c_str(), 0755);
+    // the parallel engines put every thread on one instance at a time
+    int workers = options.engine == "hda" || options.engine == "pida" ? 1 : options.threads;
+    for (int id = 0; id < workers; id++)
+        threads.emplace_back(work);
+    for (std::thread &thread : threads)
+        thread.join();
+    double wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    write_batch_summary(std::cout, results, wall_ms, options);
+    std::cout.flush();
+}
+
+#endif
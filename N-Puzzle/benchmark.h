@@ -0,0 +1,101 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include "search_node.h"
+
+// Seeded benchmark instances in the batch file format. Two tiers:
+// - walk: a random walk of the blank from the goal, never undoing the
+//   previous move, so the optimal length is at most the walk length;
+// - random: a uniformly random permutation, redrawn until solvable, which
+//   samples the whole reachable space.
+// Only the raw mt19937_64 output is used (no std distributions, whose
+// results differ between standard libraries), so a seed gives the same
+// suite everywhere.
+
+class benchmark_random
+{
+public:
+    explicit benchmark_random(uint64_t seed) : engine(seed) {}
+
+    // Uniform in [0, bound), by rejection.
+    int below(int bound)
+    {
+        uint64_t limit = UINT64_MAX - UINT64_MAX % bound;
+        uint64_t value;
+        do
+            value = engine();
+        while (value >= limit);
+        return int(value % bound);
+    }
+
+private:
+    std::mt19937_64 engine;
+};
+
+template <int W>
+search_node<W> random_walk_instance(benchmark_random &random, int length)
+{
+    search_node<W> node;
+    node.board = goal_state<W>();
+    node.blank = W * W - 1;
+    int last_move = -1;
+    for (int step = 0; step < length;)
+    {
+        int move = random.below(MOVE_COUNT);
+        int target = tables<W>.move_target[node.blank][move];
+        if (target < 0 || (last_move != -1 && move == (last_move ^ 1)))
+            continue;
+        node.board.set(node.blank, node.board.get(target));
+        node.board.set(target, 0);
+        node.blank = target;
+        last_move = move;
+        step++;
+    }
+    return node;
+}
+
+template <int W>
+search_node<W> random_permutation_instance(benchmark_random &random)
+{
+    search_node<W> node;
+    do
+    {
+        int tiles[W * W];
+        for (int cell = 0; cell < W * W; cell++)
+            tiles[cell] = cell;
+        for (int cell = W * W - 1; cell > 0; cell--)
+            std::swap(tiles[cell], tiles[random.below(cell + 1)]);
+        for (int cell = 0; cell < W * W; cell++)
+        {
+            node.board.set(cell, tiles[cell]);
+            if (tiles[cell] == 0)
+                node.blank = cell;
+        }
+    } while (!solvable(node));
+    return node;
+}
+
+// Writes count instances; walk_length <= 0 selects random permutations.
+// Returns false if an instance fails the solvability check.
+template <int W>
+bool generate_benchmark(std::ostream &out, int count, int walk_length, uint64_t seed)
+{
+    benchmark_random random(seed);
+    for (int i = 0; i < count; i++)
+    {
+        search_node<W> node = walk_length > 0 ? random_walk_instance<W>(random, walk_length)
+                                              : random_permutation_instance<W>(random);
+        if (!solvable(node))
+            return false;
+        out << W << "\n";
+        node.print_current_configuration(out);
+        out << "\n";
+    }
+    return true;
+}
+
+#endif
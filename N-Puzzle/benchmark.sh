@@ -0,0 +1,109 @@
+#!/bin/sh
+# Reproducible benchmark suite for the N-Puzzle solver.
+#
+#   ./benchmark.sh [binary] [output directory]
+#
+# Generates seeded 8/15/24-puzzle instances in difficulty tiers, then runs
+# every heuristic with every batch engine over each tier (table on the 3x3
+# tiers only; anytime has no batch engine and is not measured) and collects
+# the summaries into results.csv. A run that exceeds TIME_LIMIT seconds or
+# MEMORY_MB of memory is recorded as "limit", and a heuristic the engine
+# cannot use as "n/a". Set THREADS for
+# the batch pool and HDA*. Parallel IDA* with the pattern database is then
+# run on the 15-puzzle tiers with each of SCALING_THREADS into scaling.csv,
+# with the speedup over one thread.
+
+BINARY=${1:-./a.out}
+OUT=${2:-benchmarks}
+SEED=${SEED:-318}
+THREADS=${THREADS:-1}
+TIME_LIMIT=${TIME_LIMIT:-60}
+MEMORY_MB=${MEMORY_MB:-4096}
+SCALING_THREADS=${SCALING_THREADS:-1 2 4 8}
+
+if [ ! -x "$BINARY" ]; then
+    g++ -O2 -std=c++17 -pthread 2105028.cpp -o "$BINARY" || exit 1
+fi
+mkdir -p "$OUT"
+
+# tier name, board size, instance count, walk length or "random"
+TIERS="8-walk20 3 200 20
+8-random 3 200 random
+15-walk30 4 50 30
+15-walk60 4 20 60
+15-random 4 5 random
+24-walk40 5 10 40
+24-walk80 5 5 80"
+
+# here-documents keep the loops in this shell, so exit ends the script
+while read -r tier size count walk; do
+    "$BINARY" generate "$size" "$count" "$walk" "$SEED" > "$OUT/$tier.txt" || exit 1
+done <<EOF
+$TIERS
+EOF
+
+HEURISTICS="1:hamming 2:manhattan 3:euclidean 4:linear-conflict 5:pattern-database 6:walking-distance"
+MODES="astar epea ida pida hda bidir disk"
+RESULTS="$OUT/results.csv"
+echo "tier,heuristic,mode,instances,solved,wall_ms,expanded,expanded_per_sec,p50_ms,p90_ms,p99_ms,max_ms,max_peak_bytes" > "$RESULTS"
+
+# value of "key": in a summary line
+field() {
+    echo "$1" | sed -n "s/.*\"$2\": \([0-9.]*\).*/\1/p"
+}
+
+while read -r tier size count walk; do
+    modes=$MODES
+    [ "$size" = 3 ] && modes="$modes table"
+    for entry in $HEURISTICS; do
+        heuristic=${entry%%:*}
+        name=${entry#*:}
+        for mode in $modes; do
+            # MM needs a heuristic that can aim at the start board
+            if [ "$mode" = bidir ] && { [ "$heuristic" = 5 ] || [ "$heuristic" = 6 ]; }; then
+                echo "$tier,$name,$mode,$count,n/a,,,,,,,," >> "$RESULTS"
+                continue
+            fi
+            # stderr is dropped so runs killed by the limits stay quiet
+            summary=$(
+                exec 2>/dev/null
+                ulimit -v $((MEMORY_MB * 1024))
+                timeout "$TIME_LIMIT" "$BINARY" "$heuristic" batch "$OUT/$tier.txt" "$THREADS" "$mode" |
+                    grep '^# summary'
+            )
+            if [ -z "$summary" ]; then
+                echo "$tier,$name,$mode,$count,limit,,,,,,,," >> "$RESULTS"
+                continue
+            fi
+            line="$tier,$name,$mode"
+            for key in instances solved wall_ms expanded expanded_per_sec p50_ms p90_ms p99_ms max_ms max_peak_bytes; do
+                line="$line,$(field "$summary" "$key")"
+            done
+            echo "$line" >> "$RESULTS"
+            echo "$line"
+        done
+    done
+done <<EOF
+$TIERS
+EOF
+
+SCALING="$OUT/scaling.csv"
+echo "tier,threads,solved,wall_ms,expanded,speedup" > "$SCALING"
+for tier in 15-walk30 15-walk60 15-random; do
+    base=
+    for threads in $SCALING_THREADS; do
+        summary=$(
+            exec 2>/dev/null
+            timeout "$TIME_LIMIT" "$BINARY" 5 batch "$OUT/$tier.txt" "$threads" pida | grep '^# summary'
+        )
+        if [ -z "$summary" ]; then
+            echo "$tier,$threads,limit,,," >> "$SCALING"
+            continue
+        fi
+        wall=$(field "$summary" wall_ms)
+        base=${base:-$wall}
+        line="$tier,$threads,$(field "$summary" solved),$wall,$(field "$summary" expanded),$(awk "BEGIN { printf \"%.2f\", $base / $wall }")"
+        echo "$line" >> "$SCALING"
+        echo "$line"
+    done
+done
@@ -0,0 +1,219 @@
+#ifndef BIDIRECTIONAL_H
+#define BIDIRECTIONAL_H
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+#include "node_pool.h"
+#include "search_node.h"
+
+// Bidirectional MM search (Holte et al., "Bidirectional search that is
+// guaranteed to meet in the middle"). A forward search from the start and a
+// backward search from the goal each order their open list by
+// pr(n) = max(g + h, 2g), where the backward h measures the distance to the
+// start. Every generated child is looked up in the other direction's table
+// on its packed state, and a hit updates the best path cost U. The search
+// stops once U is no larger than the lower bound
+// max(C, fmin_F, fmin_B, gmin_F + gmin_B + 1), with C the smaller of the two
+// lowest priorities, so the path returned is optimal.
+
+template <int W>
+struct bidirectional_node : search_node<W>
+{
+    const bidirectional_node *parent_node = nullptr; // kept: the meeting state needs both halves
+    bool open = true; // false once expanded or superseded by a cheaper copy
+};
+
+template <int W, class heuristic>
+class bidirectional_solver
+{
+public:
+    typedef bidirectional_node<W> node_type;
+
+    long long explored_node = 0;
+    long long expanded_node = 0;
+    long long forward_expanded = 0;
+    long long backward_expanded = 0;
+
+    // Fills path with the blank moves from start to the goal.
+    bool solve(const search_node<W> &start, std::vector<int> &path)
+    {
+        static_assert(heuristic::retargetable, "the backward search needs distances to the start board");
+        path.clear();
+        packed_state<W> goal = goal_state<W>();
+        directions[0].target = tables<W>;
+        directions[1].target = target_tables<W>(start.board);
+
+        node_type root;
+        static_cast<search_node<W> &>(root) = start;
+        add_root(directions[0], root);
+        root.board = goal;
+        root.blank = W * W - 1;
+        add_root(directions[1], root);
+        if (start.board == goal)
+        {
+            best_cost = 0;
+            meet_forward = directions[0].table[goal];
+            meet_backward = directions[1].table[goal];
+        }
+
+        while (!directions[0].open_list.empty() && !directions[1].open_list.empty())
+        {
+            direction &forward = directions[0], &backward = directions[1];
+            double c = std::min(min_key(forward.open_list), min_key(backward.open_list));
+            double bound = std::max(std::max(c, min_key(forward.f_list)),
+                                    std::max(min_key(backward.f_list),
+                                             min_key(forward.g_list) + min_key(backward.g_list) + 1));
+            if (best_cost <= bound + 1e-9)
+                break;
+            int side = min_key(forward.open_list) <= min_key(backward.open_list) ? 0 : 1;
+            expand(side);
+        }
+        if (best_cost == INFINITY)
+            return false;
+
+        // forward half: start .. meeting state, backward half: meeting state .. goal
+        std::vector<const node_type *> states;
+        for (const node_type *node = meet_forward; node != nullptr; node = node->parent_node)
+            states.push_back(node);
+        std::reverse(states.begin(), states.end());
+        for (const node_type *node = meet_backward->parent_node; node != nullptr; node = node->parent_node)
+            states.push_back(node);
+        for (size_t i = 1; i < states.size(); i++)
+        {
+            for (int move = 0; move < MOVE_COUNT; move++)
+            {
+                if (tables<W>.move_target[states[i - 1]->blank][move] == states[i]->blank)
+                    path.push_back(move);
+            }
+        }
+        return true;
+    }
+
+    // Node slabs, tables and the three heaps of both directions.
+    size_t peak_bytes() const
+    {
+        size_t bytes = 0;
+        for (const direction &side : directions)
+        {
+            bytes += side.node_arena.allocated_bytes() + side.table.bucket_count() * sizeof(void *) +
+                     side.table.size() * (sizeof(packed_state<W>) + 2 * sizeof(void *)) +
+                     peak_entries * sizeof(entry);
+        }
+        return bytes;
+    }
+
+private:
+    struct entry
+    {
+        double key;
+        double g_n;
+        node_type *node;
+        bool operator>(const entry &other) const
+        {
+            return key != other.key ? key > other.key : g_n > other.g_n;
+        }
+    };
+    typedef std::priority_queue<entry, std::vector<entry>, std::greater<entry>> entry_heap;
+
+    // Three lazily pruned heaps over the same open nodes: by priority, by f
+    // and by g, for the termination bound.
+    struct direction
+    {
+        board_tables<W> target;
+        std::unordered_map<packed_state<W>, node_type *, packed_state_hash<W>> table;
+        entry_heap open_list;
+        entry_heap f_list;
+        entry_heap g_list;
+        node_pool<node_type> node_arena;
+    };
+
+    direction directions[2];
+    double best_cost = INFINITY;
+    const node_type *meet_forward = nullptr;
+    const node_type *meet_backward = nullptr;
+    size_t peak_entries = 0; // heap entries of one direction, all three heaps
+
+    static double priority(const node_type &node)
+    {
+        return std::max(node.priority_value, 2 * node.g_n);
+    }
+
+    static double min_key(entry_heap &heap)
+    {
+        while (!heap.empty() && !heap.top().node->open)
+            heap.pop();
+        return heap.empty() ? INFINITY : heap.top().key;
+    }
+
+    void push(direction &side, node_type *node)
+    {
+        side.open_list.push({priority(*node), node->g_n, node});
+        side.f_list.push({node->priority_value, node->g_n, node});
+        side.g_list.push({node->g_n, node->g_n, node});
+        peak_entries = std::max(peak_entries, side.open_list.size() + side.f_list.size() + side.g_list.size());
+        explored_node++;
+    }
+
+    void add_root(direction &side, const node_type &source)
+    {
+        node_type *root = side.node_arena.scratch(source);
+        root->parent_node = nullptr;
+        root->g_n = 0;
+        root->open = true;
+        evaluate<W, heuristic>(*root, side.target);
+        side.node_arena.commit();
+        side.table[root->board] = root;
+        push(side, root);
+    }
+
+    void expand(int index)
+    {
+        direction &side = directions[index];
+        direction &other = directions[1 - index];
+        min_key(side.open_list);
+        node_type *node = side.open_list.top().node;
+        side.open_list.pop();
+        node->open = false;
+        expanded_node++;
+        (index == 0 ? forward_expanded : backward_expanded)++;
+
+        for (int move = 0; move < MOVE_COUNT; move++)
+        {
+            int target = tables<W>.move_target[node->blank][move];
+            if (target < 0)
+                continue;
+            node_type *child = side.node_arena.scratch(*node);
+            child->parent_node = node;
+            child->open = true;
+            move_blank<W, heuristic>(*child, target, 1, side.target);
+            if (child->priority_value >= best_cost)
+                continue;
+
+            auto found = side.table.find(child->board);
+            if (found != side.table.end())
+            {
+                if (found->second->g_n <= child->g_n)
+                    continue;
+                found->second->open = false;
+                found->second = child;
+            }
+            else
+                side.table.emplace(child->board, child);
+            side.node_arena.commit();
+            push(side, child);
+
+            auto meeting = other.table.find(child->board);
+            if (meeting != other.table.end() && child->g_n + meeting->second->g_n < best_cost)
+            {
+                best_cost = child->g_n + meeting->second->g_n;
+                meet_forward = index == 0 ? child : meeting->second;
+                meet_backward = index == 0 ? meeting->second : child;
+            }
+        }
+    }
+};
+
+#endif
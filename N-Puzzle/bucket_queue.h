@@ -0,0 +1,85 @@
+#ifndef BUCKET_QUEUE_H
+#define BUCKET_QUEUE_H
+
+#include <cstddef>
+#include <vector>
+
+// Open list for small integer priorities: one bucket per f value, split into
+// sub-buckets by h, each used as a stack. The lowest f wins, ties go to the
+// lowest h and then to the most recently pushed node. Push is O(1); pop is
+// amortised O(1) because the f and h cursors only move past empty buckets.
+template <class node_type>
+class bucket_queue
+{
+public:
+    void push(node_type *node, int f, int h)
+    {
+        if (f >= int(buckets.size()))
+        {
+            buckets.resize(f + 1);
+            min_h.resize(f + 1, 0);
+            f_count.resize(f + 1, 0);
+        }
+        std::vector<std::vector<node_type *>> &bucket = buckets[f];
+        if (h >= int(bucket.size()))
+            bucket.resize(h + 1);
+        if (f_count[f] == 0 || h < min_h[f])
+            min_h[f] = h;
+        bucket[h].push_back(node);
+        f_count[f]++;
+        if (count == 0 || f < min_f)
+            min_f = f;
+        count++;
+    }
+
+    node_type *top()
+    {
+        seek();
+        return buckets[min_f][min_h[min_f]].back();
+    }
+
+    void pop()
+    {
+        seek();
+        buckets[min_f][min_h[min_f]].pop_back();
+        f_count[min_f]--;
+        count--;
+    }
+
+    bool empty() const
+    {
+        return count == 0;
+    }
+
+    size_t size() const
+    {
+        return count;
+    }
+
+    void clear()
+    {
+        buckets.clear();
+        min_h.clear();
+        f_count.clear();
+        count = 0;
+        min_f = 0;
+    }
+
+private:
+    std::vector<std::vector<std::vector<node_type *>>> buckets; // [f][h]
+    std::vector<int> min_h; // lowest h that may be non-empty, per f
+    std::vector<size_t> f_count;
+    size_t count = 0;
+    int min_f = 0;
+
+    void seek()
+    {
+        while (f_count[min_f] == 0)
+            min_f++;
+        std::vector<std::vector<node_type *>> &bucket = buckets[min_f];
+        while (bucket[min_h[min_f]].empty())
+            min_h[min_f]++;
+    }
+};
+
+#endif
@@ -0,0 +1,200 @@
+#ifndef CLOSED_TABLE_H
+#define CLOSED_TABLE_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "packed_state.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Open-addressing closed list keyed by packed state. Each slot keeps the
+// best g seen for its state and the node that holds it, so a cheaper path
+// found later can re-open the state. Slots are grouped by 16; a parallel
+// byte array holds a 7-bit tag per slot (0x80 when empty), and a probe
+// compares a whole group of tags at once (SSE2 when available) before
+// touching any slot. Groups are probed triangularly (1, 2, 3... groups
+// on), which visits every group of a power-of-two table without the long
+// runs of linear probing, and the table doubles at 3/4 load; states are
+// never removed.
+template <int W, class node_type>
+class closed_table
+{
+public:
+    struct slot
+    {
+        packed_state<W> board;
+        double g_n;
+        node_type *node;
+    };
+
+    closed_table()
+    {
+        resize(64);
+    }
+
+    // Slot for board, or nullptr.
+    slot *find(const packed_state<W> &board)
+    {
+        size_t hash = packed_state_hash<W>()(board);
+        size_t index;
+        bool found = locate(board, hash, index);
+        record();
+        return found ? &slots[index] : nullptr;
+    }
+
+    // Slot for board; a new slot (inserted = true) has g = infinity and no
+    // node. The reference is valid until the next insertion.
+    slot &find_or_insert(const packed_state<W> &board, bool &inserted)
+    {
+        size_t hash = packed_state_hash<W>()(board);
+        size_t index;
+        inserted = !locate(board, hash, index);
+        record();
+        if (!inserted)
+            return slots[index];
+        if ((count + 1) * 4 > capacity() * 3)
+        {
+            resize(capacity() * 2);
+            locate(board, hash, index);
+        }
+        tags[index] = tag_of(hash);
+        slots[index].board = board;
+        slots[index].g_n = INFINITY;
+        slots[index].node = nullptr;
+        count++;
+        return slots[index];
+    }
+
+    size_t size() const
+    {
+        return count;
+    }
+
+    size_t capacity() const
+    {
+        return slots.size();
+    }
+
+    double load_factor() const
+    {
+        return double(count) / capacity();
+    }
+
+    // Groups visited per lookup; 1 means the first group answered.
+    double mean_probe_length() const
+    {
+        return lookups ? double(probed_groups) / lookups : 0;
+    }
+
+    size_t max_probe_length() const
+    {
+        return longest_probe;
+    }
+
+    size_t bytes() const
+    {
+        return tags.size() + slots.size() * sizeof(slot);
+    }
+
+private:
+    static constexpr int group_size = 16;
+    static constexpr uint8_t empty_tag = 0x80;
+
+    std::vector<uint8_t> tags;
+    std::vector<slot> slots;
+    size_t group_mask = 0;
+    size_t count = 0;
+    size_t lookups = 0;
+    size_t probed_groups = 0;
+    size_t longest_probe = 0;
+    size_t last_probe = 0;
+
+    static uint8_t tag_of(size_t hash)
+    {
+        return hash & 0x7f;
+    }
+
+    // Bit i of match is set when tag i of the group equals tag, bit i of
+    // empty when slot i is free.
+    static void scan(const uint8_t *group, uint8_t tag, unsigned &match, unsigned &empty)
+    {
+#ifdef __SSE2__
+        __m128i tags16 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+        match = _mm_movemask_epi8(_mm_cmpeq_epi8(tags16, _mm_set1_epi8(char(tag))));
+        empty = _mm_movemask_epi8(tags16);
+#else
+        match = 0;
+        empty = 0;
+        for (int i = 0; i < group_size; i++)
+        {
+            match |= unsigned(group[i] == tag) << i;
+            empty |= unsigned(group[i] == empty_tag) << i;
+        }
+#endif
+    }
+
+    // Finds board (true) or the first free slot on its probe path (false);
+    // the number of groups visited is left in last_probe.
+    bool locate(const packed_state<W> &board, size_t hash, size_t &index)
+    {
+        uint8_t tag = tag_of(hash);
+        size_t group = (hash >> 7) & group_mask;
+        last_probe = 1;
+        while (true)
+        {
+            const uint8_t *group_tags = &tags[group * group_size];
+            unsigned match, empty;
+            scan(group_tags, tag, match, empty);
+            for (; match; match &= match - 1)
+            {
+                size_t candidate = group * group_size + __builtin_ctz(match);
+                if (slots[candidate].board == board)
+                {
+                    index = candidate;
+                    return true;
+                }
+            }
+            if (empty)
+            {
+                index = group * group_size + __builtin_ctz(empty);
+                return false;
+            }
+            group = (group + last_probe) & group_mask;
+            last_probe++;
+        }
+    }
+
+    // Counts the probe of the last locate() in the statistics; rehashing
+    // during a resize is not counted.
+    void record()
+    {
+        lookups++;
+        probed_groups += last_probe;
+        if (last_probe > longest_probe)
+            longest_probe = last_probe;
+    }
+
+    void resize(size_t new_capacity)
+    {
+        std::vector<uint8_t> old_tags(new_capacity, empty_tag);
+        std::vector<slot> old_slots(new_capacity);
+        old_tags.swap(tags);
+        old_slots.swap(slots);
+        group_mask = new_capacity / group_size - 1;
+        for (size_t i = 0; i < old_slots.size(); i++)
+        {
+            if (old_tags[i] == empty_tag)
+                continue;
+            size_t hash = packed_state_hash<W>()(old_slots[i].board);
+            size_t index;
+            locate(old_slots[i].board, hash, index);
+            tags[index] = old_tags[i];
+            slots[index] = old_slots[i];
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,495 @@
+#ifndef DISK_SEARCH_H
+#define DISK_SEARCH_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include "search_node.h"
+
+// Breadth-first heuristic search with delayed duplicate detection on disk.
+// Each depth layer lives in a sorted file of packed states. Children of a
+// layer are collected in a memory buffer; a full buffer is sorted, made
+// unique and written as a run file. Once the layer is done, the runs are
+// merged, and states that also appear in the current or previous layer are
+// dropped (a move can only lead back one layer, so nothing older can
+// repeat). RAM holds only the buffers, never the closed set. Children with
+// g + h above the bound are pruned; if a bound is exhausted the search
+// restarts with the smallest pruned f. A checkpoint is written at every
+// layer boundary, and a later run on the same board resumes from it.
+
+#define DISK_SEARCH_DIRECTORY "frontier"
+#define DISK_IO_RECORDS (1 << 16)
+
+template <int W>
+bool state_less(const packed_state<W> &a, const packed_state<W> &b)
+{
+    for (int i = 0; i < packed_state<W>::word_count; i++)
+    {
+        if (a.words[i] != b.words[i])
+            return a.words[i] < b.words[i];
+    }
+    return false;
+}
+
+// Sequential record file reader with its own large buffer.
+template <int W>
+class state_reader
+{
+public:
+    explicit state_reader(const std::string &path)
+        : file(fopen(path.c_str(), "rb")), buffer(DISK_IO_RECORDS)
+    {
+    }
+    state_reader(const state_reader &) = delete;
+    state_reader &operator=(const state_reader &) = delete;
+    ~state_reader()
+    {
+        if (file)
+            fclose(file);
+    }
+
+    // A missing file reads as empty.
+    bool next(packed_state<W> &state)
+    {
+        if (position == count)
+        {
+            count = file ? fread(buffer.data(), sizeof(packed_state<W>), buffer.size(), file) : 0;
+            position = 0;
+            if (count == 0)
+                return false;
+        }
+        state = buffer[position++];
+        return true;
+    }
+
+private:
+    FILE *file;
+    std::vector<packed_state<W>> buffer;
+    size_t position = 0;
+    size_t count = 0;
+};
+
+template <int W>
+class state_writer
+{
+public:
+    explicit state_writer(const std::string &path)
+        : file(fopen(path.c_str(), "wb"))
+    {
+        buffer.reserve(DISK_IO_RECORDS);
+    }
+    state_writer(const state_writer &) = delete;
+    state_writer &operator=(const state_writer &) = delete;
+    ~state_writer()
+    {
+        close();
+    }
+
+    void write(const packed_state<W> &state)
+    {
+        buffer.push_back(state);
+        written++;
+        if (buffer.size() == DISK_IO_RECORDS)
+            flush();
+    }
+
+    // False if any write failed.
+    bool close()
+    {
+        if (!file)
+            return false;
+        flush();
+        ok = fclose(file) == 0 && ok;
+        file = nullptr;
+        return ok;
+    }
+
+    size_t written = 0;
+
+private:
+    FILE *file;
+    std::vector<packed_state<W>> buffer;
+    bool ok = true;
+
+    void flush()
+    {
+        if (!buffer.empty() && fwrite(buffer.data(), sizeof(packed_state<W>), buffer.size(), file) != buffer.size())
+            ok = false;
+        buffer.clear();
+    }
+};
+
+template <int W, class heuristic>
+class disk_search_solver
+{
+public:
+    long long explored_node = 0;
+    long long expanded_node = 0;
+    long long bytes_written = 0;
+    bool resumed = false;
+
+    disk_search_solver(const std::string &directory_ = DISK_SEARCH_DIRECTORY, size_t memory_bytes = size_t(256) << 20)
+        : directory(directory_),
+          buffer_states(std::max<size_t>(memory_bytes / sizeof(packed_state<W>), DISK_IO_RECORDS))
+    {
+    }
+
+    // RAM for the child buffer as far as it was filled (never more than
+    // the memory budget) and the I/O buffers of a layer merge (two layers,
+    // the output and one per run).
+    size_t peak_bytes() const
+    {
+        return (peak_buffer + (3 + peak_runs) * DISK_IO_RECORDS) * sizeof(packed_state<W>);
+    }
+
+    // Fills path with the blank moves from start to the goal. Layer files
+    // and the checkpoint are removed once the search ends.
+    bool solve(const search_node<W> &start, std::vector<int> &path)
+    {
+        mkdir(directory.c_str(), 0755);
+        path.clear();
+        start_board = start.board;
+        children.reserve(buffer_states); // once: growing by doubling would overshoot the budget
+        double bound;
+        int depth;
+        double next_bound;
+        resumed = load_checkpoint(bound, depth, next_bound);
+        if (!resumed)
+        {
+            search_node<W> root = start;
+            root.g_n = 0;
+            evaluate<W, heuristic>(root);
+            bound = root.priority_value;
+            if (!start_iteration(depth, next_bound))
+                return false;
+        }
+
+        while (true)
+        {
+            packed_state<W> goal;
+            int status = run_iteration(bound, depth, next_bound, goal);
+            if (status < 0)
+                return false; // I/O error, checkpoint kept
+            if (status > 0)
+            {
+                bool ok = reconstruct(goal, depth, path);
+                clean_up();
+                return ok;
+            }
+            if (next_bound == INFINITY)
+            {
+                clean_up();
+                return false;
+            }
+            bound = next_bound;
+            if (!start_iteration(depth, next_bound) || !save_checkpoint(bound, depth, next_bound))
+                return false;
+        }
+    }
+
+private:
+    std::string directory;
+    size_t buffer_states;
+    std::vector<packed_state<W>> children; // a layer's children, buffer_states reserved
+    size_t peak_buffer = 0;
+    size_t peak_runs = 0;
+    packed_state<W> start_board;
+
+    std::string layer_path(int depth) const
+    {
+        return directory + "/layer_" + std::to_string(depth) + ".bin";
+    }
+
+    std::string run_path(int run) const
+    {
+        return directory + "/run_" + std::to_string(run) + ".bin";
+    }
+
+    std::string checkpoint_path() const
+    {
+        return directory + "/checkpoint";
+    }
+
+    static search_node<W> node_of(const packed_state<W> &board, int depth)
+    {
+        search_node<W> node;
+        node.board = board;
+        for (int cell = 0; cell < W * W; cell++)
+        {
+            if (board.get(cell) == 0)
+                node.blank = cell;
+        }
+        node.g_n = depth;
+        evaluate<W, heuristic>(node);
+        return node;
+    }
+
+    // Drops the layers of the previous bound and writes layer 0.
+    bool start_iteration(int &depth, double &next_bound)
+    {
+        for (int d = 1; remove(layer_path(d).c_str()) == 0; d++)
+            ;
+        state_writer<W> layer(layer_path(0));
+        layer.write(start_board);
+        depth = 0;
+        next_bound = INFINITY;
+        bytes_written += sizeof(packed_state<W>);
+        if (!layer.close())
+        {
+            std::cerr << "cannot write " << layer_path(0) << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // 1: goal found in layer `depth`, 0: bound exhausted, -1: I/O error.
+    int run_iteration(double bound, int &depth, double &next_bound, packed_state<W> &goal)
+    {
+        const packed_state<W> correct_configuration = goal_state<W>();
+        for (;; depth++)
+        {
+            std::vector<packed_state<W>> &buffer = children;
+            buffer.clear();
+            int runs = 0;
+            state_reader<W> layer(layer_path(depth));
+            packed_state<W> state;
+            while (layer.next(state))
+            {
+                expanded_node++;
+                if (state == correct_configuration)
+                {
+                    goal = state;
+                    return 1;
+                }
+                search_node<W> node = node_of(state, depth);
+                for (int move = 0; move < MOVE_COUNT; move++)
+                {
+                    int target = tables<W>.move_target[node.blank][move];
+                    if (target < 0)
+                        continue;
+                    search_node<W> child = node;
+                    move_blank<W, heuristic>(child, target);
+                    if (child.priority_value > bound + 1e-9)
+                    {
+                        next_bound = std::min(next_bound, child.priority_value);
+                        continue;
+                    }
+                    explored_node++;
+                    buffer.push_back(child.board);
+                    if (buffer.size() == buffer_states && !write_run(buffer, runs++))
+                        return -1;
+                }
+            }
+            if (!buffer.empty() && !write_run(buffer, runs++))
+                return -1;
+            peak_runs = std::max<size_t>(peak_runs, runs);
+
+            size_t count;
+            if (!merge_runs(runs, depth, count))
+                return -1;
+            if (count == 0)
+                return 0;
+            if (!save_checkpoint(bound, depth + 1, next_bound))
+                return -1;
+        }
+    }
+
+    bool write_run(std::vector<packed_state<W>> &buffer, int run)
+    {
+        peak_buffer = std::max(peak_buffer, buffer.size());
+        std::sort(buffer.begin(), buffer.end(), state_less<W>);
+        buffer.erase(std::unique(buffer.begin(), buffer.end()), buffer.end());
+        state_writer<W> writer(run_path(run));
+        for (const packed_state<W> &state : buffer)
+            writer.write(state);
+        bytes_written += writer.written * sizeof(packed_state<W>);
+        buffer.clear();
+        if (!writer.close())
+        {
+            std::cerr << "cannot write " << run_path(run) << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // k-way merge of the runs into layer depth + 1, dropping duplicates and
+    // anything in layers depth and depth - 1.
+    bool merge_runs(int runs, int depth, size_t &count)
+    {
+        struct head
+        {
+            packed_state<W> state;
+            int run;
+            bool operator>(const head &other) const
+            {
+                return state_less<W>(other.state, state);
+            }
+        };
+        std::vector<std::unique_ptr<state_reader<W>>> readers;
+        std::priority_queue<head, std::vector<head>, std::greater<head>> heads;
+        for (int run = 0; run < runs; run++)
+        {
+            readers.emplace_back(new state_reader<W>(run_path(run)));
+            head first;
+            first.run = run;
+            if (readers.back()->next(first.state))
+                heads.push(first);
+        }
+
+        state_reader<W> current(layer_path(depth));
+        state_reader<W> previous(depth > 0 ? layer_path(depth - 1) : std::string());
+        packed_state<W> current_state, previous_state;
+        bool current_left = current.next(current_state);
+        bool previous_left = previous.next(previous_state);
+
+        state_writer<W> next(layer_path(depth + 1));
+        bool have_last = false;
+        packed_state<W> last;
+        while (!heads.empty())
+        {
+            head top = heads.top();
+            heads.pop();
+            head following;
+            following.run = top.run;
+            if (readers[top.run]->next(following.state))
+                heads.push(following);
+            if (!(have_last && last == top.state))
+            {
+                have_last = true;
+                last = top.state;
+                while (current_left && state_less<W>(current_state, top.state))
+                    current_left = current.next(current_state);
+                while (previous_left && state_less<W>(previous_state, top.state))
+                    previous_left = previous.next(previous_state);
+                if (!(current_left && current_state == top.state) && !(previous_left && previous_state == top.state))
+                    next.write(top.state);
+            }
+        }
+        count = next.written;
+        bytes_written += next.written * sizeof(packed_state<W>);
+        readers.clear();
+        for (int run = 0; run < runs; run++)
+            remove(run_path(run).c_str());
+        if (!next.close())
+        {
+            std::cerr << "cannot write " << layer_path(depth + 1) << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Binary search of a sorted layer file.
+    bool layer_contains(int depth, const packed_state<W> &state) const
+    {
+        FILE *file = fopen(layer_path(depth).c_str(), "rb");
+        if (!file)
+            return false;
+        fseek(file, 0, SEEK_END);
+        long low = 0, high = ftell(file) / sizeof(packed_state<W>);
+        bool found = false;
+        while (low < high && !found)
+        {
+            long middle = (low + high) / 2;
+            packed_state<W> probe;
+            fseek(file, middle * sizeof(packed_state<W>), SEEK_SET);
+            if (fread(&probe, sizeof(probe), 1, file) != 1)
+                break;
+            if (probe == state)
+                found = true;
+            else if (state_less<W>(probe, state))
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        fclose(file);
+        return found;
+    }
+
+    // Walks back from the goal one layer at a time: some neighbour of each
+    // state must sit in the layer before it.
+    bool reconstruct(const packed_state<W> &goal, int depth, std::vector<int> &path) const
+    {
+        search_node<W> node = node_of(goal, depth);
+        for (int d = depth - 1; d >= 0; d--)
+        {
+            bool stepped = false;
+            for (int move = 0; move < MOVE_COUNT && !stepped; move++)
+            {
+                int target = tables<W>.move_target[node.blank][move];
+                if (target < 0)
+                    continue;
+                search_node<W> parent = node;
+                parent.board.set(node.blank, node.board.get(target));
+                parent.board.set(target, 0);
+                parent.blank = target;
+                if (layer_contains(d, parent.board))
+                {
+                    path.push_back(move ^ 1); // the parent's blank moves back onto node's blank
+                    node = parent;
+                    stepped = true;
+                }
+            }
+            if (!stepped)
+                return false;
+        }
+        std::reverse(path.begin(), path.end());
+        return true;
+    }
+
+    bool save_checkpoint(double bound, int depth, double next_bound) const
+    {
+        std::string temporary = checkpoint_path() + ".tmp";
+        FILE *file = fopen(temporary.c_str(), "w");
+        if (!file)
+            return false;
+        fprintf(file, "%s\n%d %.17g %d %.17g %lld %lld %lld\n", heuristic::name, W, bound, depth, next_bound,
+                expanded_node, explored_node, bytes_written);
+        for (int i = 0; i < packed_state<W>::word_count; i++)
+            fprintf(file, "%llu\n", (unsigned long long)start_board.words[i]);
+        bool ok = fclose(file) == 0;
+        return ok && rename(temporary.c_str(), checkpoint_path().c_str()) == 0;
+    }
+
+    // Picks up a checkpoint left by an interrupted run on the same board
+    // with the same heuristic.
+    bool load_checkpoint(double &bound, int &depth, double &next_bound)
+    {
+        FILE *file = fopen(checkpoint_path().c_str(), "r");
+        if (!file)
+            return false;
+        char name[128] = "";
+        int size;
+        long long expanded, explored, written;
+        bool ok = fgets(name, sizeof(name), file) && std::string(name) == std::string(heuristic::name) + "\n" &&
+                  fscanf(file, "%d %lf %d %lf %lld %lld %lld", &size, &bound, &depth, &next_bound,
+                         &expanded, &explored, &written) == 7 &&
+                  size == W;
+        for (int i = 0; ok && i < packed_state<W>::word_count; i++)
+        {
+            unsigned long long word;
+            ok = fscanf(file, "%llu", &word) == 1 && word == start_board.words[i];
+        }
+        fclose(file);
+        if (!ok)
+            return false;
+        expanded_node = expanded;
+        explored_node = explored;
+        bytes_written = written;
+        return true;
+    }
+
+    void clean_up() const
+    {
+        for (int d = 0; remove(layer_path(d).c_str()) == 0; d++)
+            ;
+        remove(checkpoint_path().c_str());
+    }
+};
+
+#endif
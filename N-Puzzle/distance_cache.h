@@ -0,0 +1,124 @@
+#ifndef DISTANCE_CACHE_H
+#define DISTANCE_CACHE_H
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include "packed_state.h"
+#include "search_node.h"
+
+// Exact distances to the goal learned from earlier optimal solutions: every
+// board on a solution path is stored with its remaining distance and the
+// next move of the path, so the rest of the path can be replayed from any
+// of them. Least recently used boards are evicted at capacity.
+//
+// Boards are always touched in path order, start to goal, so a board is
+// never more recent than the board its move leads to; the least recent
+// board is then nobody's successor, and eviction cannot break a chain.
+
+template <int W>
+class distance_cache
+{
+public:
+    explicit distance_cache(size_t capacity_ = 0) : capacity(capacity_) {}
+
+    void set_capacity(size_t capacity_)
+    {
+        capacity = capacity_;
+        evict();
+    }
+
+    // Remaining distance of board, -1 if unknown; does not count as a use.
+    int peek(const packed_state<W> &board) const
+    {
+        auto found = index.find(board);
+        return found == index.end() ? -1 : found->second->distance;
+    }
+
+    // Appends the cached moves from node to the goal to path; false, with
+    // path unchanged, if node is not cached.
+    bool follow(search_node<W> node, std::vector<int> &path)
+    {
+        const packed_state<W> goal = goal_state<W>();
+        size_t length = path.size();
+        while (node.board != goal)
+        {
+            auto found = index.find(node.board);
+            if (found == index.end())
+            {
+                path.resize(length);
+                return false;
+            }
+            int move = found->second->move;
+            order.splice(order.begin(), order, found->second);
+            path.push_back(move);
+            int target = tables<W>.move_target[node.blank][move];
+            node.board.set(node.blank, node.board.get(target));
+            node.board.set(target, 0);
+            node.blank = target;
+        }
+        return true;
+    }
+
+    // Records every board on an optimal path from start.
+    void store(search_node<W> node, const std::vector<int> &path)
+    {
+        for (size_t i = 0; i < path.size(); i++)
+        {
+            auto found = index.find(node.board);
+            if (found != index.end())
+            {
+                // another optimal path may go on differently; this one is
+                // touched through to the goal, so it takes over
+                found->second->move = path[i];
+                order.splice(order.begin(), order, found->second);
+            }
+            else
+            {
+                order.push_front({node.board, int(path.size() - i), path[i]});
+                index.emplace(node.board, order.begin());
+            }
+            int target = tables<W>.move_target[node.blank][path[i]];
+            node.board.set(node.blank, node.board.get(target));
+            node.board.set(target, 0);
+            node.blank = target;
+        }
+        evict();
+    }
+
+    size_t size() const
+    {
+        return index.size();
+    }
+
+    // Rough footprint: list nodes plus hash buckets and nodes.
+    size_t bytes() const
+    {
+        return order.size() * (sizeof(entry) + 2 * sizeof(void *)) +
+               index.size() * (sizeof(packed_state<W>) + 3 * sizeof(void *)) +
+               index.bucket_count() * sizeof(void *);
+    }
+
+private:
+    struct entry
+    {
+        packed_state<W> board;
+        int distance;
+        int move;
+    };
+
+    size_t capacity;
+    std::list<entry> order; // most recent first
+    std::unordered_map<packed_state<W>, typename std::list<entry>::iterator, packed_state_hash<W>> index;
+
+    void evict()
+    {
+        while (order.size() > capacity)
+        {
+            index.erase(order.back().board);
+            order.pop_back();
+        }
+    }
+};
+
+#endif
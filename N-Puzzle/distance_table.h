@@ -0,0 +1,238 @@
+#ifndef DISTANCE_TABLE_H
+#define DISTANCE_TABLE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "pattern_database.h"
+#include "search_node.h"
+
+// Complete distance table for the 8-puzzle: the optimal distance of all
+// 9!/2 = 181,440 solvable states, found by one BFS from the goal. A state
+// is ranked by its blank cell and the Lehmer rank of its eight tiles in
+// reading order, halved: the two orders that differ only in the last two
+// tiles have adjacent ranks 2k and 2k + 1, and exactly one of them is
+// solvable (which one depends on the permutation and the blank cell), so
+// both share the slot k. Each entry is the distance mod 16 in a nibble
+// (90,720 bytes); the graph is bipartite, so a neighbour is exactly one
+// move closer or farther and the residue is enough to descend greedily to
+// the goal. The table is written next to the pattern databases and
+// memory-mapped.
+
+#define DISTANCE_TABLE_MAGIC 0x5444434e // "NCDT"
+#define DISTANCE_TABLE_VERSION 1
+#define DISTANCE_TABLE_ORDERS 20160 // 8! / 2 tile orders per blank cell
+#define DISTANCE_TABLE_STATES (9 * DISTANCE_TABLE_ORDERS)
+
+struct distance_table_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;
+    uint32_t states;
+};
+
+class distance_table
+{
+public:
+    distance_table() {}
+    distance_table(const distance_table &) = delete;
+    distance_table &operator=(const distance_table &) = delete;
+    ~distance_table()
+    {
+        if (mapping)
+            munmap(mapping, mapping_size);
+    }
+
+    static uint32_t rank(const packed_state<3> &board)
+    {
+        int order[8];
+        int blank = 0;
+        for (int cell = 0, count = 0; cell < 9; cell++)
+        {
+            int tile = board.get(cell);
+            if (tile == 0)
+                blank = cell;
+            else
+                order[count++] = tile - 1;
+        }
+        return blank * DISTANCE_TABLE_ORDERS + uint32_t(rank_positions(order, 8, 8) >> 1);
+    }
+
+    // Optimal distance of a solvable board, mod 16.
+    int residue(const packed_state<3> &board) const
+    {
+        uint32_t index = rank(board);
+        return (table[index >> 1] >> ((index & 1) * 4)) & 15;
+    }
+
+    // Maps the table, building and writing it first if it is missing or
+    // stale.
+    bool load(const std::string &directory = PDB_DIRECTORY)
+    {
+        if (table != nullptr)
+            return true;
+        std::string path = directory + "/distance_3.bin";
+        if (map(path))
+            return true;
+        std::cerr << "Building distance table " << path << std::endl;
+        mkdir(directory.c_str(), 0755);
+        if (!write(path, build()) || !map(path))
+        {
+            std::cerr << "cannot write distance table " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // The move to the neighbour one step closer to the goal, whose
+    // distance mod 16 is distance; -1 if there is none (the goal itself or
+    // an unsolvable board). lookups counts the table reads.
+    int descend(const search_node<3> &node, int distance, long long &lookups) const
+    {
+        for (int move = 0; move < MOVE_COUNT; move++)
+        {
+            int target = tables<3>.move_target[node.blank][move];
+            if (target < 0)
+                continue;
+            packed_state<3> next = node.board;
+            next.set(node.blank, next.get(target));
+            next.set(target, 0);
+            lookups++;
+            if (residue(next) == ((distance + 15) & 15))
+                return move;
+        }
+        return -1;
+    }
+
+    // Greedy descent: each move goes to the neighbour one step closer.
+    // lookups counts the table reads.
+    bool solve(const search_node<3> &start, std::vector<int> &path, long long &lookups) const
+    {
+        path.clear();
+        search_node<3> node = start;
+        const packed_state<3> goal = goal_state<3>();
+        int distance = residue(node.board);
+        lookups = 1;
+        while (node.board != goal)
+        {
+            int step = descend(node, distance, lookups);
+            if (step < 0 || path.size() > 31)
+                return false; // not a solvable board
+            int target = tables<3>.move_target[node.blank][step];
+            node.board.set(node.blank, node.board.get(target));
+            node.board.set(target, 0);
+            node.blank = target;
+            distance = (distance + 15) & 15;
+            path.push_back(step);
+        }
+        return true;
+    }
+
+private:
+    const uint8_t *table = nullptr;
+    void *mapping = nullptr;
+    size_t mapping_size = 0;
+
+    static std::vector<uint8_t> build()
+    {
+        std::vector<uint8_t> distance(DISTANCE_TABLE_STATES, 255);
+        search_node<3> goal;
+        goal.board = goal_state<3>();
+        goal.blank = 8;
+        distance[rank(goal.board)] = 0;
+        std::vector<search_node<3>> current(1, goal), next;
+        for (int depth = 1; !current.empty(); depth++)
+        {
+            next.clear();
+            for (const search_node<3> &node : current)
+            {
+                for (int move = 0; move < MOVE_COUNT; move++)
+                {
+                    int target = tables<3>.move_target[node.blank][move];
+                    if (target < 0)
+                        continue;
+                    search_node<3> child = node;
+                    child.board.set(node.blank, node.board.get(target));
+                    child.board.set(target, 0);
+                    child.blank = target;
+                    uint8_t &entry = distance[rank(child.board)];
+                    if (entry != 255)
+                        continue;
+                    entry = depth;
+                    next.push_back(child);
+                }
+            }
+            std::swap(current, next);
+        }
+
+        std::vector<uint8_t> packed(DISTANCE_TABLE_STATES / 2, 0);
+        for (uint32_t i = 0; i < DISTANCE_TABLE_STATES; i++)
+            packed[i >> 1] |= (distance[i] & 15) << ((i & 1) * 4);
+        return packed;
+    }
+
+    static bool write(const std::string &path, const std::vector<uint8_t> &packed)
+    {
+        distance_table_header header = {DISTANCE_TABLE_MAGIC, DISTANCE_TABLE_VERSION, 3, DISTANCE_TABLE_STATES};
+        std::string temporary = path + ".tmp";
+        FILE *file = fopen(temporary.c_str(), "wb");
+        if (!file)
+            return false;
+        bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                  fwrite(packed.data(), 1, packed.size(), file) == packed.size();
+        ok = fclose(file) == 0 && ok;
+        return ok && rename(temporary.c_str(), path.c_str()) == 0;
+    }
+
+    bool map(const std::string &path)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat info;
+        size_t expected = sizeof(distance_table_header) + DISTANCE_TABLE_STATES / 2;
+        if (fstat(fd, &info) != 0 || size_t(info.st_size) != expected)
+        {
+            close(fd);
+            return false;
+        }
+        void *base = mmap(nullptr, expected, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (base == MAP_FAILED)
+            return false;
+        const distance_table_header *header = static_cast<const distance_table_header *>(base);
+        if (header->magic != DISTANCE_TABLE_MAGIC || header->version != DISTANCE_TABLE_VERSION || header->size != 3 ||
+            header->states != DISTANCE_TABLE_STATES)
+        {
+            munmap(base, expected);
+            return false;
+        }
+        mapping = base;
+        mapping_size = expected;
+        table = static_cast<const uint8_t *>(base) + sizeof(distance_table_header);
+        return true;
+    }
+};
+
+// Loaded by main before the first 3x3 solve; read-only afterwards.
+inline distance_table eight_puzzle_table;
+
+// For code generic over the width; other widths have no table.
+template <int W>
+bool solve_with_distance_table(const search_node<W> &start, std::vector<int> &path, long long &lookups)
+{
+    if constexpr (W == 3)
+        return eight_puzzle_table.solve(start, path, lookups);
+    else
+        return false;
+}
+
+#endif
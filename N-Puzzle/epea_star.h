@@ -0,0 +1,180 @@
+#ifndef EPEA_STAR_H
+#define EPEA_STAR_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "astar.h"
+#include "closed_table.h"
+#include "node_pool.h"
+#include "path_store.h"
+#include "search_node.h"
+
+// Enhanced partial-expansion A* (EPEA*, Felner et al.). A node is queued
+// under a stored value F that starts at its f. Expanding it generates only
+// the children whose f equals F and puts the node back under the smallest
+// child f above F, so children that would never be expanded before the
+// goal are not stored. For tile_local heuristics the change in f of every
+// move is read from an operator table indexed by blank cell, move and the
+// tile that moves, without making the child; with four operators at most,
+// scanning them all is as cheap as keeping them sorted by that change.
+// Other heuristics make each child to learn its f but still only store the
+// matching ones.
+
+// 1 + delta h of the blank moving from a cell in a direction, by the tile
+// it swaps with.
+template <int W, class heuristic>
+struct operator_table
+{
+    double delta_f[W * W][MOVE_COUNT][W * W];
+
+    operator_table()
+    {
+        for (int blank = 0; blank < W * W; blank++)
+        {
+            for (int move = 0; move < MOVE_COUNT; move++)
+            {
+                int target = tables<W>.move_target[blank][move];
+                for (int tile = 1; tile < W * W && target >= 0; tile++)
+                {
+                    packed_state<W> board{};
+                    board.set(blank, tile); // delta() only reads the tile's new cell
+                    delta_f[blank][move][tile] = 1 + heuristic::delta(board, target, blank);
+                }
+            }
+        }
+    }
+};
+
+template <int W, class heuristic>
+inline const operator_table<W, heuristic> operator_tables;
+
+template <int W, class heuristic>
+class epea_star_solver
+{
+public:
+    typedef search_node<W> node_type;
+
+    long long explored_node = 0;
+    long long expanded_node = 0;  // pops, partial or final
+    long long reinserted_node = 0; // pops that put the node back
+    long long reopened_node = 0;
+
+    bool solve(const node_type &start, std::vector<int> &path)
+    {
+        const packed_state<W> correct_configuration = goal_state<W>();
+        path.clear();
+        paths.clear();
+        node_type *root = node_arena.scratch(start);
+        root->path_index = path_store::root;
+        root->g_n = 0;
+        evaluate<W, heuristic>(*root);
+        node_arena.commit();
+        open_list.push(root);
+        explored_node++;
+        bool inserted;
+        typename closed_table<W, node_type>::slot &entry = closed_list.find_or_insert(root->board, inserted);
+        entry.g_n = 0;
+        entry.node = root;
+
+        while (!open_list.empty())
+        {
+            node_type *promising_node = open_list.top();
+            open_list.pop();
+            if (closed_list.find(promising_node->board)->node != promising_node)
+            {
+                node_arena.recycle(promising_node); // re-opened later with a lower g
+                continue;
+            }
+            expanded_node++;
+            if (promising_node->board == correct_configuration)
+            {
+                path = paths.moves(promising_node->path_index);
+                return true;
+            }
+            double next_value = generate_children(*promising_node);
+            if (next_value < INFINITY)
+            {
+                promising_node->priority_value = next_value;
+                open_list.push(promising_node);
+                reinserted_node++;
+            }
+            else
+            {
+                closed_list.find(promising_node->board)->node = nullptr; // fully expanded
+                node_arena.recycle(promising_node);
+            }
+            peak_open = std::max(peak_open, open_list.size());
+        }
+        return false;
+    }
+
+    size_t peak_bytes() const
+    {
+        return node_arena.allocated_bytes() + closed_list.bytes() + paths.bytes() +
+               peak_open * sizeof(node_type *);
+    }
+
+private:
+    closed_table<W, node_type> closed_list;
+    open_list_queue<node_type, heuristic::integer> open_list;
+    node_pool<node_type> node_arena;
+    path_store paths;
+    size_t peak_open = 0;
+
+    // Stores the children with f equal to the node's stored value (or
+    // below it, on the first expansion) and returns the smallest child f
+    // above it, INFINITY if there is none.
+    double generate_children(node_type &node)
+    {
+        double stored = node.priority_value;
+        double wanted = stored - (node.g_n + node.h_n);
+        double next_value = INFINITY;
+        for (int move = 0; move < MOVE_COUNT; move++)
+        {
+            int target = tables<W>.move_target[node.blank][move];
+            if (target < 0)
+                continue;
+            node_type *child = nullptr;
+            double delta_f;
+            if constexpr (heuristic::tile_local)
+                delta_f = operator_tables<W, heuristic>.delta_f[node.blank][move][node.board.get(target)];
+            else
+            {
+                child = node_arena.scratch(node);
+                move_blank<W, heuristic>(*child, target);
+                delta_f = child->priority_value - (node.g_n + node.h_n);
+            }
+            if (delta_f > wanted + 1e-9)
+            {
+                next_value = std::min(next_value, stored + delta_f - wanted);
+                continue;
+            }
+            // stored by an earlier expansion; the first one also takes the
+            // f drops of an inconsistent heuristic
+            if (delta_f < wanted - 1e-9 && wanted > 1e-9)
+                continue;
+
+            if (child == nullptr)
+            {
+                child = node_arena.scratch(node);
+                move_blank<W, heuristic>(*child, target);
+            }
+            bool inserted;
+            typename closed_table<W, node_type>::slot &entry = closed_list.find_or_insert(child->board, inserted);
+            if (entry.g_n <= child->g_n)
+                continue;
+            if (!inserted && entry.node == nullptr)
+                reopened_node++; // fully expanded, now re-opened with a lower g
+            entry.g_n = child->g_n;
+            entry.node = child;
+            child->path_index = paths.add(node.path_index, move);
+            node_arena.commit();
+            open_list.push(child);
+            explored_node++;
+        }
+        return next_value;
+    }
+};
+
+#endif
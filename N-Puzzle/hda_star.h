@@ -0,0 +1,292 @@
+#ifndef HDA_STAR_H
+#define HDA_STAR_H
+
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "astar.h"
+#include "node_pool.h"
+#include "search_node.h"
+
+// Hash-distributed A*: every state is owned by the thread its closed-list
+// hash maps to. Threads expand their own open lists and ship children to
+// the owner through lock-free MPSC inboxes, so no search structure is
+// shared. A goal becomes the incumbent; the search stops once every thread
+// is idle (no open node below the incumbent cost, empty inbox) and no
+// message is in flight, which proves the incumbent optimal.
+
+template <int W>
+struct hda_node : search_node<W>
+{
+    const hda_node *parent_node = nullptr; // nodes are shared between threads, so the path stays as pointers
+    hda_node *next_message = nullptr;
+};
+
+// Producers push whole chains with one CAS; the owner takes everything at
+// once with an exchange.
+template <class node_type>
+class mpsc_inbox
+{
+public:
+    void push_chain(node_type *first, node_type *last)
+    {
+        node_type *head = inbox_head.load(std::memory_order_relaxed);
+        do
+        {
+            last->next_message = head;
+        } while (!inbox_head.compare_exchange_weak(head, first, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    node_type *take_all()
+    {
+        return inbox_head.exchange(nullptr, std::memory_order_acquire);
+    }
+
+    bool empty() const
+    {
+        return inbox_head.load(std::memory_order_acquire) == nullptr;
+    }
+
+private:
+    std::atomic<node_type *> inbox_head{nullptr};
+};
+
+template <int W, class heuristic>
+class hda_star_solver
+{
+public:
+    typedef hda_node<W> node_type;
+
+    long long explored_node = 0;
+    long long expanded_node = 0;
+    std::vector<long long> thread_expanded;
+
+    explicit hda_star_solver(int thread_count_)
+        : thread_count(thread_count_ > 0 ? thread_count_ : 1),
+          workers(thread_count)
+    {
+    }
+
+    // Returns the goal node, whose parent chain is the solution path, or
+    // nullptr. Nodes stay valid until the solver is destroyed.
+    const node_type *solve(const search_node<W> &start)
+    {
+        correct_configuration = goal_state<W>();
+        worker &owner = workers[owner_of(start.board)];
+        node_type *root = owner.node_arena.scratch(node_type());
+        static_cast<search_node<W> &>(*root) = start;
+        root->parent_node = nullptr;
+        root->g_n = 0;
+        evaluate<W, heuristic>(*root);
+        owner.node_arena.commit();
+        in_flight = 1;
+        owner.inbox.push_chain(root, root);
+
+        std::vector<std::thread> threads;
+        for (int id = 0; id < thread_count; id++)
+            threads.emplace_back(&hda_star_solver::run, this, id);
+        for (std::thread &thread : threads)
+            thread.join();
+
+        thread_expanded.clear();
+        for (worker &w : workers)
+        {
+            explored_node += w.explored_node;
+            expanded_node += w.expanded_node;
+            thread_expanded.push_back(w.expanded_node);
+        }
+        return incumbent;
+    }
+
+    // Node slabs plus closed list entries and buckets over all threads.
+    size_t peak_bytes() const
+    {
+        size_t bytes = 0;
+        for (const worker &w : workers)
+        {
+            bytes += w.node_arena.allocated_bytes() + w.closed_list.bucket_count() * sizeof(void *) +
+                     w.closed_list.size() * (sizeof(packed_state<W>) + 2 * sizeof(void *));
+        }
+        return bytes;
+    }
+
+private:
+    struct outgoing_chain
+    {
+        node_type *first = nullptr;
+        node_type *last = nullptr;
+        int count = 0;
+    };
+
+    struct worker
+    {
+        mpsc_inbox<node_type> inbox;
+        std::atomic<bool> idle{false};
+        std::unordered_map<packed_state<W>, node_type *, packed_state_hash<W>> closed_list;
+        open_list_queue<node_type, heuristic::integer> open_list;
+        node_pool<node_type> node_arena;
+        std::vector<outgoing_chain> outgoing;
+        long long explored_node = 0;
+        long long expanded_node = 0;
+    };
+
+    static const int batch_size = 64;
+
+    int thread_count;
+    std::vector<worker> workers;
+    packed_state<W> correct_configuration;
+
+    std::atomic<long long> in_flight{0};
+    std::atomic<unsigned long long> activity{0};
+    std::atomic<bool> done{false};
+    std::atomic<double> incumbent_cost{INFINITY};
+    std::mutex incumbent_mutex;
+    const node_type *incumbent = nullptr;
+
+    int owner_of(const packed_state<W> &board) const
+    {
+        return (packed_state_hash<W>()(board) >> 32) % thread_count;
+    }
+
+    void run(int id)
+    {
+        worker &self = workers[id];
+        self.outgoing.assign(thread_count, outgoing_chain());
+        while (!done.load())
+        {
+            if (!self.inbox.empty())
+            {
+                if (self.idle.load())
+                {
+                    self.idle = false;
+                    activity++;
+                }
+                long long received = 0;
+                for (node_type *node = self.inbox.take_all(); node != nullptr;)
+                {
+                    node_type *next = node->next_message;
+                    insert(self, node);
+                    node = next;
+                    received++;
+                }
+                in_flight -= received;
+            }
+
+            if (!self.open_list.empty() && self.open_list.top()->priority_value < incumbent_cost.load())
+            {
+                node_type *promising_node = self.open_list.top();
+                self.open_list.pop();
+                if (self.closed_list[promising_node->board] != promising_node)
+                    continue; // reopened later with a lower g
+                self.expanded_node++;
+                if (promising_node->board == correct_configuration)
+                    offer_incumbent(promising_node);
+                else
+                    generate_children(self, *promising_node);
+                continue;
+            }
+
+            flush(self);
+            if (!self.inbox.empty())
+                continue;
+            self.idle = true;
+            check_termination();
+            std::this_thread::yield();
+        }
+    }
+
+    // Keeps the node if its state is new to this thread or reached with a
+    // lower g than before.
+    void insert(worker &self, node_type *node)
+    {
+        if (node->priority_value >= incumbent_cost.load())
+            return;
+        auto found = self.closed_list.find(node->board);
+        if (found != self.closed_list.end() && found->second->g_n <= node->g_n)
+            return;
+        self.closed_list[node->board] = node;
+        self.open_list.push(node);
+        self.explored_node++;
+    }
+
+    void generate_children(worker &self, node_type &node)
+    {
+        for (int move = 0; move < MOVE_COUNT; move++)
+        {
+            int target = tables<W>.move_target[node.blank][move];
+            if (target < 0)
+                continue;
+            node_type *child = self.node_arena.scratch(node);
+            child->parent_node = &node;
+            move_blank<W, heuristic>(*child, target);
+            if (child->priority_value >= incumbent_cost.load())
+                continue;
+            if (node.parent_node != nullptr && child->board == node.parent_node->board)
+                continue;
+            int owner = owner_of(child->board);
+            self.node_arena.commit();
+            if (owner == int(&self - &workers[0]))
+            {
+                insert(self, child);
+                continue;
+            }
+            outgoing_chain &chain = self.outgoing[owner];
+            child->next_message = chain.first;
+            chain.first = child;
+            if (chain.last == nullptr)
+                chain.last = child;
+            if (++chain.count == batch_size)
+                send(owner, chain);
+        }
+    }
+
+    void send(int owner, outgoing_chain &chain)
+    {
+        in_flight += chain.count; // counted before the chain becomes visible
+        workers[owner].inbox.push_chain(chain.first, chain.last);
+        chain = outgoing_chain();
+    }
+
+    void flush(worker &self)
+    {
+        for (int owner = 0; owner < thread_count; owner++)
+        {
+            if (self.outgoing[owner].count > 0)
+                send(owner, self.outgoing[owner]);
+        }
+    }
+
+    void offer_incumbent(const node_type *node)
+    {
+        std::lock_guard<std::mutex> lock(incumbent_mutex);
+        if (node->g_n < incumbent_cost.load())
+        {
+            incumbent = node;
+            incumbent_cost = node->g_n;
+        }
+    }
+
+    // A thread turns active (bumping activity) before it consumes a message
+    // and in_flight only drops after that, so seeing every thread idle, no
+    // message in flight and an unchanged activity count means nothing can
+    // wake up again.
+    void check_termination()
+    {
+        unsigned long long before = activity.load();
+        for (worker &w : workers)
+        {
+            if (!w.idle.load())
+                return;
+        }
+        if (in_flight.load() != 0)
+            return;
+        if (activity.load() == before)
+            done = true;
+    }
+};
+
+#endif
@@ -0,0 +1,298 @@
+#ifndef HEURISTIC_KERNELS_H
+#define HEURISTIC_KERNELS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "packed_state.h"
+#include "search_node.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HEURISTIC_KERNELS_X86
+#endif
+
+// Whole-board kernels behind the Manhattan and linear conflict heuristics
+// for boards of up to 32 cells (5x5). The board is unpacked to one byte
+// per cell; the goal row and column of every tile are looked up with byte
+// shuffles against 32-entry tables (two 16-entry halves, picked by the
+// tile's bit 4), and the per-cell distances are summed with a sum of
+// absolute differences. The same pass produces line digits for the
+// conflict count: for each cell, the goal column + 1 of a tile that
+// belongs to that row (the goal row + 1 in the column case), 0 otherwise.
+// A row's or column's digits read as a base W + 1 number index a table of
+// its conflicts. AVX2, SSSE3 or scalar code is chosen once at startup.
+
+#define KERNEL_CELLS 32
+#define KERNEL_MAX_WIDTH 5
+
+struct kernel_tables
+{
+    alignas(32) uint8_t goal_row[KERNEL_CELLS]; // by tile value
+    alignas(32) uint8_t goal_col[KERNEL_CELLS];
+    alignas(32) uint8_t row_of[KERNEL_CELLS]; // by cell
+    alignas(32) uint8_t col_of[KERNEL_CELLS];
+};
+
+template <int W>
+constexpr kernel_tables make_kernel_tables(const board_tables<W> &goal)
+{
+    kernel_tables bytes{};
+    for (int i = 0; i < W * W; i++)
+    {
+        bytes.goal_row[i] = uint8_t(goal.goal_row[i]);
+        bytes.goal_col[i] = uint8_t(goal.goal_col[i]);
+        bytes.row_of[i] = uint8_t(goal.row_of[i]);
+        bytes.col_of[i] = uint8_t(goal.col_of[i]);
+    }
+    return bytes;
+}
+
+template <int W>
+inline constexpr kernel_tables standard_kernel_tables = make_kernel_tables<W>(tables<W>);
+
+// Returns the Manhattan distance of tiles (KERNEL_CELLS bytes, zero past
+// the board); fills the line digits when row_digits is not null.
+typedef int (*board_kernel)(const uint8_t *tiles, const kernel_tables &goal, uint8_t *row_digits,
+                            uint8_t *col_digits);
+
+inline int scalar_board_kernel(const uint8_t *tiles, const kernel_tables &goal, uint8_t *row_digits,
+                               uint8_t *col_digits)
+{
+    int distance = 0;
+    for (int cell = 0; cell < KERNEL_CELLS; cell++)
+    {
+        int tile = tiles[cell];
+        int row = goal.goal_row[tile], col = goal.goal_col[tile];
+        bool present = tile != 0;
+        distance += present * (abs(row - goal.row_of[cell]) + abs(col - goal.col_of[cell]));
+        if (row_digits != nullptr)
+        {
+            row_digits[cell] = present && row == goal.row_of[cell] ? col + 1 : 0;
+            col_digits[cell] = present && col == goal.col_of[cell] ? row + 1 : 0;
+        }
+    }
+    return distance;
+}
+
+#ifdef HEURISTIC_KERNELS_X86
+
+__attribute__((target("ssse3"))) inline int ssse3_board_kernel(const uint8_t *tiles, const kernel_tables &goal,
+                                                               uint8_t *row_digits, uint8_t *col_digits)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i fifteen = _mm_set1_epi8(15);
+    const __m128i row_low = _mm_load_si128(reinterpret_cast<const __m128i *>(goal.goal_row));
+    const __m128i row_high = _mm_load_si128(reinterpret_cast<const __m128i *>(goal.goal_row + 16));
+    const __m128i col_low = _mm_load_si128(reinterpret_cast<const __m128i *>(goal.goal_col));
+    const __m128i col_high = _mm_load_si128(reinterpret_cast<const __m128i *>(goal.goal_col + 16));
+    __m128i sum = zero;
+    for (int half = 0; half < KERNEL_CELLS; half += 16)
+    {
+        __m128i tile = _mm_loadu_si128(reinterpret_cast<const __m128i *>(tiles + half));
+        __m128i high = _mm_cmpgt_epi8(tile, fifteen);
+        __m128i blank = _mm_cmpeq_epi8(tile, zero);
+        __m128i row = _mm_or_si128(_mm_and_si128(high, _mm_shuffle_epi8(row_high, tile)),
+                                   _mm_andnot_si128(high, _mm_shuffle_epi8(row_low, tile)));
+        __m128i col = _mm_or_si128(_mm_and_si128(high, _mm_shuffle_epi8(col_high, tile)),
+                                   _mm_andnot_si128(high, _mm_shuffle_epi8(col_low, tile)));
+        __m128i cell_row = _mm_load_si128(reinterpret_cast<const __m128i *>(goal.row_of + half));
+        __m128i cell_col = _mm_load_si128(reinterpret_cast<const __m128i *>(goal.col_of + half));
+        __m128i distance = _mm_add_epi8(_mm_abs_epi8(_mm_sub_epi8(row, cell_row)),
+                                        _mm_abs_epi8(_mm_sub_epi8(col, cell_col)));
+        sum = _mm_add_epi64(sum, _mm_sad_epu8(_mm_andnot_si128(blank, distance), zero));
+        if (row_digits != nullptr)
+        {
+            __m128i in_row = _mm_andnot_si128(blank, _mm_cmpeq_epi8(row, cell_row));
+            __m128i in_col = _mm_andnot_si128(blank, _mm_cmpeq_epi8(col, cell_col));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(row_digits + half),
+                             _mm_and_si128(in_row, _mm_add_epi8(col, one)));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(col_digits + half),
+                             _mm_and_si128(in_col, _mm_add_epi8(row, one)));
+        }
+    }
+    return _mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+}
+
+__attribute__((target("avx2"))) inline int avx2_board_kernel(const uint8_t *tiles, const kernel_tables &goal,
+                                                             uint8_t *row_digits, uint8_t *col_digits)
+{
+    // vpshufb looks up within each 128-bit lane, so both lanes get the
+    // same 16-entry half
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i row_low = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i *>(goal.goal_row)));
+    const __m256i row_high = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i *>(goal.goal_row + 16)));
+    const __m256i col_low = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i *>(goal.goal_col)));
+    const __m256i col_high = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i *>(goal.goal_col + 16)));
+    __m256i tile = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(tiles));
+    __m256i high = _mm256_cmpgt_epi8(tile, _mm256_set1_epi8(15));
+    __m256i blank = _mm256_cmpeq_epi8(tile, zero);
+    __m256i row = _mm256_blendv_epi8(_mm256_shuffle_epi8(row_low, tile), _mm256_shuffle_epi8(row_high, tile), high);
+    __m256i col = _mm256_blendv_epi8(_mm256_shuffle_epi8(col_low, tile), _mm256_shuffle_epi8(col_high, tile), high);
+    __m256i cell_row = _mm256_load_si256(reinterpret_cast<const __m256i *>(goal.row_of));
+    __m256i cell_col = _mm256_load_si256(reinterpret_cast<const __m256i *>(goal.col_of));
+    __m256i distance = _mm256_add_epi8(_mm256_abs_epi8(_mm256_sub_epi8(row, cell_row)),
+                                       _mm256_abs_epi8(_mm256_sub_epi8(col, cell_col)));
+    __m256i sum = _mm256_sad_epu8(_mm256_andnot_si256(blank, distance), zero);
+    if (row_digits != nullptr)
+    {
+        const __m256i one = _mm256_set1_epi8(1);
+        __m256i in_row = _mm256_andnot_si256(blank, _mm256_cmpeq_epi8(row, cell_row));
+        __m256i in_col = _mm256_andnot_si256(blank, _mm256_cmpeq_epi8(col, cell_col));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(row_digits), _mm256_and_si256(in_row, _mm256_add_epi8(col, one)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(col_digits), _mm256_and_si256(in_col, _mm256_add_epi8(row, one)));
+    }
+    __m128i lanes = _mm_add_epi64(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    return _mm_cvtsi128_si32(lanes) + _mm_cvtsi128_si32(_mm_srli_si128(lanes, 8));
+}
+
+#endif
+
+struct board_kernel_choice
+{
+    board_kernel run;
+    const char *name;
+};
+
+inline board_kernel_choice select_board_kernel()
+{
+#ifdef HEURISTIC_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return {avx2_board_kernel, "avx2"};
+    if (__builtin_cpu_supports("ssse3"))
+        return {ssse3_board_kernel, "ssse3"};
+#endif
+    return {scalar_board_kernel, "scalar"};
+}
+
+inline const board_kernel_choice selected_board_kernel = select_board_kernel();
+
+// Runs the selected kernel on board against goal; returns the Manhattan
+// distance.
+template <int W>
+int run_board_kernel(const packed_state<W> &board, const board_tables<W> &goal, uint8_t *row_digits = nullptr,
+                     uint8_t *col_digits = nullptr)
+{
+    static_assert(W * W <= KERNEL_CELLS, "board too large for the kernels");
+    alignas(16) uint8_t tiles[KERNEL_CELLS] = {};
+#ifdef __SSE2__
+    if constexpr (packed_state<W>::bits == 4)
+    {
+        // one word of nibbles: split and interleave the low and high halves
+        const __m128i nibble = _mm_set1_epi8(0x0f);
+        __m128i packed = _mm_cvtsi64_si128((long long)board.words[0]);
+        __m128i low = _mm_and_si128(packed, nibble);
+        __m128i high = _mm_and_si128(_mm_srli_epi16(packed, 4), nibble);
+        _mm_store_si128(reinterpret_cast<__m128i *>(tiles), _mm_unpacklo_epi8(low, high));
+    }
+    else
+#endif
+    {
+        for (int cell = 0; cell < W * W; cell++)
+            tiles[cell] = uint8_t(board.get(cell));
+    }
+    if (&goal == &tables<W>)
+        return selected_board_kernel.run(tiles, standard_kernel_tables<W>, row_digits, col_digits);
+    kernel_tables retargeted = make_kernel_tables<W>(goal);
+    return selected_board_kernel.run(tiles, retargeted, row_digits, col_digits);
+}
+
+// With HEURISTIC_DEBUG every kernel result is checked against the scalar
+// code it replaces.
+inline double checked_kernel_value(double kernel_value, double scalar_value, const char *heuristic_name)
+{
+#ifdef HEURISTIC_DEBUG
+    if (kernel_value != scalar_value)
+    {
+        std::cerr << heuristic_name << " kernel mismatch (" << selected_board_kernel.name << "): kernel "
+                  << kernel_value << ", scalar " << scalar_value << std::endl;
+        abort();
+    }
+#else
+    (void)scalar_value;
+    (void)heuristic_name;
+#endif
+    return kernel_value;
+}
+
+// Tiles of one line that have to leave it so the rest are in goal order:
+// line length minus the longest increasing run of goal positions.
+inline int line_conflicts(const int *goal_position, int count)
+{
+    int longest[MAX_PACKED_SIZE];
+    int best = 0;
+    for (int i = 0; i < count; i++)
+    {
+        longest[i] = 1;
+        for (int j = 0; j < i; j++)
+        {
+            if (goal_position[j] < goal_position[i] && longest[j] + 1 > longest[i])
+                longest[i] = longest[j] + 1;
+        }
+        best = std::max(best, longest[i]);
+    }
+    return count - best;
+}
+
+// Conflicts of every line digit pattern, first cell most significant:
+// (W + 1)^W entries, 7776 for 5x5.
+template <int W>
+const std::vector<uint8_t> &line_conflict_table()
+{
+    static const std::vector<uint8_t> table = []
+    {
+        int size = 1;
+        for (int i = 0; i < W; i++)
+            size *= W + 1;
+        std::vector<uint8_t> conflicts(size);
+        for (int code = 0; code < size; code++)
+        {
+            int digits[W];
+            for (int i = W - 1, rest = code; i >= 0; i--, rest /= W + 1)
+                digits[i] = rest % (W + 1);
+            int goal_position[W];
+            int count = 0;
+            for (int i = 0; i < W; i++)
+            {
+                if (digits[i] != 0)
+                    goal_position[count++] = digits[i] - 1;
+            }
+            conflicts[code] = uint8_t(line_conflicts(goal_position, count));
+        }
+        return conflicts;
+    }();
+    return table;
+}
+
+// Conflicts of a line from the goal positions of its own tiles, in line
+// order; the table for boards up to KERNEL_MAX_WIDTH, the search above it.
+template <int W>
+int table_line_conflicts(const int *goal_position, int count)
+{
+    if (count < 2)
+        return 0;
+    if constexpr (W <= KERNEL_MAX_WIDTH)
+    {
+        int code = 0;
+        for (int i = 0; i < W; i++)
+            code = code * (W + 1) + (i < count ? goal_position[i] + 1 : 0);
+        return line_conflict_table<W>()[code];
+    }
+    else
+        return line_conflicts(goal_position, count);
+}
+
+// Conflicts of the line whose cells are first, first + stride, ...
+template <int W>
+int line_digit_conflicts(const uint8_t *digits, int first, int stride)
+{
+    int code = 0;
+    for (int i = 0; i < W; i++)
+        code = code * (W + 1) + digits[first + i * stride];
+    return line_conflict_table<W>()[code];
+}
+
+#endif
@@ -0,0 +1,328 @@
+#ifndef HEURISTICS_H
+#define HEURISTICS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include "heuristic_kernels.h"
+#include "packed_state.h"
+#include "pattern_database.h"
+#include "walking_distance.h"
+#include "search_node.h"
+
+// Heuristic policies. evaluate() scores a whole board; delta() takes the
+// board after a move, where the tile now on cell `to` came from cell `from`
+// (now the blank), and returns the change in h. `integer` marks heuristics
+// whose values are whole numbers, which lets the open list use buckets.
+// Both measure the distance to `goal`, normally the standard goal;
+// `retargetable` marks heuristics that also work for any other target
+// board, which the backward half of a bidirectional search needs.
+// `indexed` heuristics keep table indices in the node's heuristic_state:
+// index() derives them from a board and advance() replaces delta().
+// `tile_local` marks heuristics whose delta() only depends on the moved
+// tile and its two cells, so it can be tabulated per blank cell, move and
+// tile.
+
+template <int W>
+struct hamming_distance
+{
+    static constexpr bool integer = true;
+    static constexpr bool retargetable = true;
+    static constexpr bool indexed = false;
+    static constexpr bool tile_local = true;
+    static constexpr const char *name = "Hamming distance";
+
+    static double evaluate(const packed_state<W> &board, const board_tables<W> &goal = tables<W>)
+    {
+        double distance = 0;
+        for (int cell = 0; cell < W * W; cell++)
+        {
+            int value = board.get(cell);
+            if (value != 0 && goal.goal_cell[value] != cell)
+            {
+                distance++;
+            }
+        }
+        return distance;
+    }
+
+    static double delta(const packed_state<W> &board, int from, int to, const board_tables<W> &goal = tables<W>)
+    {
+        int value = board.get(to);
+        return (goal.goal_cell[value] != to) - (goal.goal_cell[value] != from);
+    }
+};
+
+template <int W>
+struct manhattan_distane
+{
+    static constexpr bool integer = true;
+    static constexpr bool retargetable = true;
+    static constexpr bool indexed = false;
+    static constexpr bool tile_local = true;
+    static constexpr const char *name = "Manhattan distance";
+
+    static int tile_distance(int value, int cell, const board_tables<W> &goal = tables<W>)
+    {
+        return abs(goal.goal_row[value] - tables<W>.row_of[cell]) +
+               abs(goal.goal_col[value] - tables<W>.col_of[cell]);
+    }
+
+    static double scalar_evaluate(const packed_state<W> &board, const board_tables<W> &goal = tables<W>)
+    {
+        double distance = 0;
+        for (int cell = 0; cell < W * W; cell++)
+        {
+            int value = board.get(cell);
+            if (value != 0)
+                distance += tile_distance(value, cell, goal);
+        }
+        return distance;
+    }
+
+    static double evaluate(const packed_state<W> &board, const board_tables<W> &goal = tables<W>)
+    {
+        if constexpr (W <= KERNEL_MAX_WIDTH)
+            return checked_kernel_value(run_board_kernel<W>(board, goal), scalar_evaluate(board, goal), name);
+        else
+            return scalar_evaluate(board, goal);
+    }
+
+    static double delta(const packed_state<W> &board, int from, int to, const board_tables<W> &goal = tables<W>)
+    {
+        int value = board.get(to);
+        return tile_distance(value, to, goal) - tile_distance(value, from, goal);
+    }
+};
+
+template <int W>
+struct euclidean_distance
+{
+    static constexpr bool integer = false;
+    static constexpr bool retargetable = true;
+    static constexpr bool indexed = false;
+    static constexpr bool tile_local = true;
+    static constexpr const char *name = "Euclidean distance";
+
+    static double tile_distance(int value, int cell, const board_tables<W> &goal = tables<W>)
+    {
+        int row = goal.goal_row[value] - tables<W>.row_of[cell];
+        int col = goal.goal_col[value] - tables<W>.col_of[cell];
+        return sqrt(double(row * row + col * col));
+    }
+
+    static double evaluate(const packed_state<W> &board, const board_tables<W> &goal = tables<W>)
+    {
+        double distance = 0;
+        for (int cell = 0; cell < W * W; cell++)
+        {
+            int value = board.get(cell);
+            if (value != 0)
+                distance += tile_distance(value, cell, goal);
+        }
+        return distance;
+    }
+
+    static double delta(const packed_state<W> &board, int from, int to, const board_tables<W> &goal = tables<W>)
+    {
+        int value = board.get(to);
+        return tile_distance(value, to, goal) - tile_distance(value, from, goal);
+    }
+};
+
+template <int W>
+struct linear_conflict
+{
+    static constexpr bool integer = true;
+    static constexpr bool retargetable = true;
+    static constexpr bool indexed = false;
+    static constexpr bool tile_local = false;
+    static constexpr const char *name = "Linear conflict";
+
+    static int row_conflicts(const packed_state<W> &board, int row, const board_tables<W> &goal = tables<W>)
+    {
+        int goal_position[W];
+        int count = 0;
+        for (int j = 0; j < W; j++)
+        {
+            int value = board.get(row * W + j);
+            if (value != 0 && goal.goal_row[value] == row) // Row te belong kore
+                goal_position[count++] = goal.goal_col[value];
+        }
+        return table_line_conflicts<W>(goal_position, count);
+    }
+
+    static int column_conflicts(const packed_state<W> &board, int col, const board_tables<W> &goal = tables<W>)
+    {
+        int goal_position[W];
+        int count = 0;
+        for (int i = 0; i < W; i++)
+        {
+            int value = board.get(i * W + col);
+            if (value != 0 && goal.goal_col[value] == col) // correct column e belong kore
+                goal_position[count++] = goal.goal_row[value];
+        }
+        return table_line_conflicts<W>(goal_position, count);
+    }
+
+    static double scalar_evaluate(const packed_state<W> &board, const board_tables<W> &goal = tables<W>)
+    {
+        int conflicts = 0;
+        for (int i = 0; i < W; ++i)
+        {
+            conflicts += row_conflicts(board, i, goal);
+            conflicts += column_conflicts(board, i, goal);
+        }
+        return manhattan_distane<W>::scalar_evaluate(board, goal) + 2 * conflicts;
+    }
+
+    static double evaluate(const packed_state<W> &board, const board_tables<W> &goal = tables<W>)
+    {
+        if constexpr (W <= KERNEL_MAX_WIDTH)
+        {
+            uint8_t row_digits[KERNEL_CELLS], col_digits[KERNEL_CELLS];
+            int distance = run_board_kernel<W>(board, goal, row_digits, col_digits);
+            int conflicts = 0;
+            for (int i = 0; i < W; ++i)
+            {
+                conflicts += line_digit_conflicts<W>(row_digits, i * W, 1);
+                conflicts += line_digit_conflicts<W>(col_digits, i, W);
+            }
+            return checked_kernel_value(distance + 2 * conflicts, scalar_evaluate(board, goal), name);
+        }
+        else
+            return scalar_evaluate(board, goal);
+    }
+
+    static double delta(const packed_state<W> &board, int from, int to, const board_tables<W> &goal = tables<W>)
+    {
+        // only the two rows (vertical move) or two columns (horizontal move)
+        // the tile crossed can change their conflict count
+        packed_state<W> before = board;
+        before.set(from, board.get(to));
+        before.set(to, 0);
+
+        int conflicts = 0;
+        int from_row = tables<W>.row_of[from], to_row = tables<W>.row_of[to];
+        int from_col = tables<W>.col_of[from], to_col = tables<W>.col_of[to];
+        if (from_row != to_row)
+        {
+            conflicts += row_conflicts(board, from_row, goal) + row_conflicts(board, to_row, goal);
+            conflicts -= row_conflicts(before, from_row, goal) + row_conflicts(before, to_row, goal);
+        }
+        else
+        {
+            conflicts += column_conflicts(board, from_col, goal) + column_conflicts(board, to_col, goal);
+            conflicts -= column_conflicts(before, from_col, goal) + column_conflicts(before, to_col, goal);
+        }
+        return manhattan_distane<W>::delta(board, from, to, goal) + 2 * conflicts;
+    }
+};
+
+// One set per board width, loaded by main before any search with this
+// heuristic starts; read-only afterwards, so solver threads can share it.
+inline pattern_database_set pattern_databases[MAX_PACKED_SIZE + 1];
+
+template <int W>
+struct pattern_database_distance
+{
+    static constexpr bool integer = true;
+    static constexpr bool retargetable = false; // tables are built for the standard goal
+    static constexpr bool indexed = false;
+    static constexpr bool tile_local = false;
+    static constexpr const char *name = "Additive pattern database";
+
+    static void tile_positions(const packed_state<W> &board, int *tile_position)
+    {
+        for (int cell = 0; cell < W * W; cell++)
+            tile_position[board.get(cell)] = cell;
+    }
+
+    static double evaluate(const packed_state<W> &board, const board_tables<W> & = tables<W>)
+    {
+        int tile_position[W * W];
+        tile_positions(board, tile_position);
+        return pattern_databases[W].distance(tile_position);
+    }
+
+    static double delta(const packed_state<W> &board, int from, int to, const board_tables<W> & = tables<W>)
+    {
+        // only the table holding the moved tile changes
+        int tile_position[W * W];
+        tile_positions(board, tile_position);
+        int value = board.get(to);
+        const pattern_database &pdb = pattern_databases[W].owner(value);
+        int after = pdb.lookup_positions(tile_position);
+        tile_position[value] = from;
+        int before = pdb.lookup_positions(tile_position);
+        return after - before;
+    }
+};
+
+// Built by main before any search with this heuristic starts.
+inline walking_distance_table walking_distance_tables[MAX_PACKED_SIZE + 1];
+
+// Walking distance: fewest vertical moves for the row count matrix plus
+// fewest horizontal moves for the column one. A vertical move only changes
+// the row matrix and a horizontal one only the column matrix, so each move
+// is one link lookup on the matching index.
+template <int W>
+struct walking_distance
+{
+    static constexpr bool integer = true;
+    static constexpr bool retargetable = false; // tables are built for the standard goal
+    static constexpr bool indexed = true;
+    static constexpr bool tile_local = false;
+    static constexpr const char *name = "Walking distance";
+
+    // row table index in the low 16 bits, column table index in the high 16
+    static uint32_t index(const packed_state<W> &board)
+    {
+        uint8_t rows[W * W] = {}, cols[W * W] = {};
+        int blank = 0;
+        for (int cell = 0; cell < W * W; cell++)
+        {
+            int value = board.get(cell);
+            if (value == 0)
+            {
+                blank = cell;
+                continue;
+            }
+            rows[tables<W>.row_of[cell] * W + tables<W>.goal_row[value]]++;
+            cols[tables<W>.col_of[cell] * W + tables<W>.goal_col[value]]++;
+        }
+        const walking_distance_table &table = walking_distance_tables[W];
+        return table.index(rows, tables<W>.row_of[blank]) | uint32_t(table.index(cols, tables<W>.col_of[blank])) << 16;
+    }
+
+    static double distance(uint32_t state)
+    {
+        const walking_distance_table &table = walking_distance_tables[W];
+        return table.distance[state & 0xffff] + table.distance[state >> 16];
+    }
+
+    static double evaluate(const packed_state<W> &board, const board_tables<W> & = tables<W>)
+    {
+        return distance(index(board));
+    }
+
+    // The tile `value` slid from cell `from` to cell `to` (the old blank).
+    static double advance(uint32_t &state, int value, int from, int to)
+    {
+        const walking_distance_table &table = walking_distance_tables[W];
+        double before = distance(state);
+        if (tables<W>.row_of[from] != tables<W>.row_of[to])
+        {
+            int direction = tables<W>.row_of[from] < tables<W>.row_of[to] ? 0 : 1;
+            state = (state & 0xffff0000u) | table.next(state & 0xffff, direction, tables<W>.goal_row[value]);
+        }
+        else
+        {
+            int direction = tables<W>.col_of[from] < tables<W>.col_of[to] ? 0 : 1;
+            state = (state & 0xffffu) | uint32_t(table.next(state >> 16, direction, tables<W>.goal_col[value])) << 16;
+        }
+        return distance(state) - before;
+    }
+};
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef IDA_STAR_H
+#define IDA_STAR_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <vector>
+#include "move_pruning.h"
+#include "search_node.h"
+
+// IDA*: cost-bounded depth-first search that makes and unmakes moves on a
+// single board, so memory only grows with the depth of the current path.
+// Without a closed list, moves are filtered by the move pruning automaton
+// instead, which skips sequences with a known shorter or equal
+// transposition before the child is made.
+template <int W, class heuristic>
+class ida_star_solver
+{
+public:
+    typedef search_node<W> node_type;
+
+    long long explored_node = 0;
+    long long expanded_node = 0;
+    size_t deepest_path = 0; // longest move stack any pass reached
+    const std::atomic<bool> *stop = nullptr; // set by a parallel caller to abandon the current pass
+
+    bool solve(node_type node, std::vector<int> &path)
+    {
+        node.g_n = 0;
+        evaluate<W, heuristic>(node);
+        explored_node++;
+        double bound = node.priority_value;
+        while (true)
+        {
+            double next_bound = INFINITY;
+            path.clear();
+            if (search(node, bound, move_pruning_automaton::start, path, next_bound))
+                return true;
+            if (next_bound == INFINITY)
+                return false;
+            bound = next_bound;
+        }
+    }
+
+    // The working board and the move stack; the recursion itself is not
+    // counted.
+    size_t peak_bytes(const std::vector<int> &path) const
+    {
+        return sizeof(node_type) + path.capacity() * sizeof(int);
+    }
+
+    // One cost-bounded pass below node, entered in pruning_state; the moves
+    // to a goal are appended to path. next_bound collects the smallest f
+    // beyond bound.
+    bool search(node_type &node, double bound, int pruning_state, std::vector<int> &path, double &next_bound)
+    {
+        if (node.priority_value > bound + 1e-9)
+        {
+            next_bound = std::min(next_bound, node.priority_value);
+            return false;
+        }
+        if (node.board == correct_configuration)
+            return true;
+        if (stop != nullptr && stop->load(std::memory_order_relaxed))
+            return false;
+        expanded_node++;
+
+        int cell = node.blank;
+        for (int move = 0; move < MOVE_COUNT; move++)
+        {
+            int next_state = pruning.next(pruning_state, move);
+            if (next_state < 0)
+                continue;
+            int target = tables<W>.move_target[cell][move];
+            if (target < 0)
+                continue;
+            explored_node++;
+            double h_n = node.h_n;
+            uint32_t heuristic_state = node.heuristic_state;
+            move_blank<W, heuristic>(node, target);
+            path.push_back(move);
+            deepest_path = std::max(deepest_path, path.size());
+            if (search(node, bound, next_state, path, next_bound))
+                return true;
+            path.pop_back();
+            undo_move_blank(node, cell, h_n, heuristic_state);
+        }
+        return false;
+    }
+
+private:
+    const packed_state<W> correct_configuration = goal_state<W>();
+    const move_pruning_automaton &pruning = move_pruning();
+};
+
+#endif
@@ -0,0 +1,311 @@
+#ifndef MOVE_PRUNING_H
+#define MOVE_PRUNING_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include "pattern_database.h"
+#include "search_node.h"
+
+// Finite-state-machine move pruning (Taylor and Korf). A move sequence is
+// a duplicate when another sequence of no greater length, lexicographically
+// smaller if equally long, has the same effect on the board and keeps the
+// blank inside the bounding box of the first one's blank path; the second
+// is then legal wherever the first is, so a path containing a duplicate
+// can always be rewritten into a smaller one of no greater cost, and
+// leaving out every path that contains one keeps an optimal solution.
+//
+// Duplicates are found once, by enumerating blank paths up to
+// MOVE_PRUNING_DEPTH moves on a board large enough to have no edges, level
+// by level so that only minimal ones are recorded (their proper substrings
+// are not duplicates). An Aho-Corasick automaton over the recorded
+// sequences then tells, for the moves made so far, which next moves would
+// complete one. Undoing the previous move is the length 2 case. The
+// transition table is written next to the pattern databases and read back
+// by later runs.
+
+#define MOVE_PRUNING_DEPTH 12
+#define MOVE_PRUNING_MAGIC 0x4d53464e // "NFSM"
+#define MOVE_PRUNING_VERSION 1
+
+struct move_pruning_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t max_length;
+    uint32_t state_count;
+};
+
+class move_pruning_automaton
+{
+public:
+    static constexpr int start = 0;
+
+    // Reads the table for max_length from directory, building and writing
+    // it first if it is missing or stale.
+    void load(const std::string &directory = PDB_DIRECTORY, int max_length = MOVE_PRUNING_DEPTH)
+    {
+        std::string path = directory + "/move_pruning_" + std::to_string(max_length);
+        if (read(path, max_length))
+            return;
+        std::cerr << "Building move pruning table " << path << std::endl;
+        build(max_length);
+        mkdir(directory.c_str(), 0755);
+        if (!write(path, max_length))
+            std::cerr << "cannot write move pruning table " << path << std::endl;
+    }
+
+    // State after move, or -1 when the moves so far end in a duplicate.
+    int next(int state, int move) const
+    {
+        return transitions[state * MOVE_COUNT + move];
+    }
+
+    size_t state_count() const
+    {
+        return transitions.size() / MOVE_COUNT;
+    }
+
+private:
+    // extent of a blank path relative to its start
+    struct footprint
+    {
+        int8_t top, bottom, left, right;
+        int32_t next; // next footprint with the same effect, -1 at the end
+    };
+
+    std::vector<int> transitions;
+
+    // enumeration scratch
+    std::vector<std::vector<uint8_t>> duplicates;
+    int grid_width = 0;
+    std::vector<int> grid; // tile at each cell; tiles start on the cell of their number
+    std::vector<uint64_t> effect_keys;
+    std::vector<int32_t> effect_heads;
+    std::vector<footprint> footprints;
+    std::vector<uint8_t> sequence;
+
+    bool read(const std::string &path, int max_length)
+    {
+        FILE *file = fopen(path.c_str(), "rb");
+        if (!file)
+            return false;
+        move_pruning_header header;
+        bool ok = fread(&header, sizeof(header), 1, file) == 1 && header.magic == MOVE_PRUNING_MAGIC &&
+                  header.version == MOVE_PRUNING_VERSION && int(header.max_length) == max_length &&
+                  header.state_count > 0;
+        if (ok)
+        {
+            transitions.resize(size_t(header.state_count) * MOVE_COUNT);
+            ok = fread(transitions.data(), sizeof(int), transitions.size(), file) == transitions.size() &&
+                 fgetc(file) == EOF;
+        }
+        fclose(file);
+        for (size_t i = 0; ok && i < transitions.size(); i++)
+            ok = transitions[i] >= -1 && transitions[i] < int(header.state_count);
+        if (!ok)
+            transitions.clear();
+        return ok;
+    }
+
+    bool write(const std::string &path, int max_length) const
+    {
+        move_pruning_header header = {MOVE_PRUNING_MAGIC, MOVE_PRUNING_VERSION, uint32_t(max_length),
+                                      uint32_t(state_count())};
+        std::string temporary = path + ".tmp";
+        FILE *file = fopen(temporary.c_str(), "wb");
+        if (!file)
+            return false;
+        bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                  fwrite(transitions.data(), sizeof(int), transitions.size(), file) == transitions.size();
+        ok = fclose(file) == 0 && ok;
+        return ok && rename(temporary.c_str(), path.c_str()) == 0;
+    }
+
+    static uint64_t mix(uint64_t x)
+    {
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    // Zobrist term of tile standing on cell; tiles at home add nothing, so
+    // the key only depends on what the sequence displaced.
+    uint64_t term(int tile, int cell) const
+    {
+        return tile == cell ? 0 : mix(uint64_t(tile) * grid.size() + cell + 1);
+    }
+
+    // Slot of key in the effect table, inserting it if absent.
+    size_t effect_slot(uint64_t key)
+    {
+        size_t mask = effect_keys.size() - 1;
+        size_t index = mix(key) & mask;
+        while (effect_heads[index] != -2 && effect_keys[index] != key)
+            index = (index + 1) & mask;
+        if (effect_heads[index] == -2)
+        {
+            effect_keys[index] = key;
+            effect_heads[index] = -1;
+        }
+        return index;
+    }
+
+    void build(int max_length)
+    {
+        grid_width = 2 * max_length + 3;
+        grid.resize(grid_width * grid_width);
+        for (size_t cell = 0; cell < grid.size(); cell++)
+            grid[cell] = int(cell);
+        // fewer than 2 * 3^max_length sequences survive the inverse pruning
+        size_t expected = 2;
+        for (int length = 0; length < max_length; length++)
+            expected *= 3;
+        size_t capacity = 1;
+        while (capacity < expected)
+            capacity <<= 1;
+        effect_keys.assign(capacity, 0);
+        effect_heads.assign(capacity, -2);
+        footprints.push_back({0, 0, 0, 0, -1});
+        effect_heads[effect_slot(0)] = 0;
+
+        build_automaton();
+        int center = max_length + 1;
+        for (int length = 1; length <= max_length; length++)
+        {
+            sequence.clear();
+            enumerate(length, start, 0, center, center, 0, 0, 0, 0);
+            build_automaton();
+        }
+
+        std::vector<int>().swap(grid);
+        std::vector<uint64_t>().swap(effect_keys);
+        std::vector<int32_t>().swap(effect_heads);
+        std::vector<footprint>().swap(footprints);
+        std::vector<std::vector<uint8_t>>().swap(duplicates);
+    }
+
+    // Extends the current sequence to length moves along non-pruned
+    // transitions, recording the complete sequences that are duplicates.
+    void enumerate(int length, int state, uint64_t key, int row, int col, int top, int bottom, int left, int right)
+    {
+        int depth = int(sequence.size());
+        if (depth == length)
+        {
+            // every footprint already recorded is shorter, or as long and
+            // lexicographically smaller
+            size_t slot = effect_slot(key);
+            for (int32_t i = effect_heads[slot]; i != -1; i = footprints[i].next)
+            {
+                const footprint &other = footprints[i];
+                if (other.top >= top && other.bottom <= bottom && other.left >= left && other.right <= right)
+                {
+                    duplicates.push_back(sequence);
+                    return;
+                }
+            }
+            footprints.push_back({int8_t(top), int8_t(bottom), int8_t(left), int8_t(right), effect_heads[slot]});
+            effect_heads[slot] = int32_t(footprints.size() - 1);
+            return;
+        }
+        static const int row_step[MOVE_COUNT] = {-1, 1, 0, 0};
+        static const int col_step[MOVE_COUNT] = {0, 0, -1, 1};
+        int center = (grid_width - 1) / 2;
+        for (int move = 0; move < MOVE_COUNT; move++)
+        {
+            int next_state = next(state, move);
+            if (next_state < 0)
+                continue;
+            int next_row = row + row_step[move], next_col = col + col_step[move];
+            int blank_cell = row * grid_width + col, tile_cell = next_row * grid_width + next_col;
+            int blank = grid[blank_cell], tile = grid[tile_cell];
+            uint64_t next_key = key ^ term(blank, blank_cell) ^ term(tile, tile_cell) ^ term(blank, tile_cell) ^
+                                term(tile, blank_cell);
+            std::swap(grid[blank_cell], grid[tile_cell]);
+            sequence.push_back(uint8_t(move));
+            enumerate(length, next_state, next_key, next_row, next_col, std::min(top, next_row - center),
+                      std::max(bottom, next_row - center), std::min(left, next_col - center),
+                      std::max(right, next_col - center));
+            sequence.pop_back();
+            std::swap(grid[blank_cell], grid[tile_cell]);
+        }
+    }
+
+    // Aho-Corasick goto function over the duplicates found so far, with
+    // every state that ends in one removed.
+    void build_automaton()
+    {
+        std::vector<int> trie(MOVE_COUNT, -1);
+        std::vector<char> dead(1, 0);
+        for (const std::vector<uint8_t> &duplicate : duplicates)
+        {
+            int state = 0;
+            for (uint8_t move : duplicate)
+            {
+                if (trie[state * MOVE_COUNT + move] < 0)
+                {
+                    trie[state * MOVE_COUNT + move] = int(dead.size());
+                    trie.insert(trie.end(), MOVE_COUNT, -1);
+                    dead.push_back(0);
+                }
+                state = trie[state * MOVE_COUNT + move];
+            }
+            dead[state] = 1;
+        }
+
+        std::vector<int> fail(dead.size(), 0);
+        std::queue<int> queue;
+        for (int move = 0; move < MOVE_COUNT; move++)
+        {
+            int &child = trie[move];
+            if (child < 0)
+                child = 0;
+            else
+                queue.push(child);
+        }
+        while (!queue.empty())
+        {
+            int state = queue.front();
+            queue.pop();
+            dead[state] |= dead[fail[state]];
+            for (int move = 0; move < MOVE_COUNT; move++)
+            {
+                int &child = trie[state * MOVE_COUNT + move];
+                int fallback = trie[fail[state] * MOVE_COUNT + move];
+                if (child < 0)
+                    child = fallback;
+                else
+                {
+                    fail[child] = fallback;
+                    queue.push(child);
+                }
+            }
+        }
+
+        for (size_t i = 0; i < trie.size(); i++)
+        {
+            if (dead[trie[i]])
+                trie[i] = -1;
+        }
+        transitions.swap(trie);
+    }
+};
+
+// Loaded on first use; read-only afterwards, so solver threads can share it.
+inline const move_pruning_automaton &move_pruning()
+{
+    static const move_pruning_automaton automaton = []
+    {
+        move_pruning_automaton loaded;
+        loaded.load();
+        return loaded;
+    }();
+    return automaton;
+}
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef NODE_POOL_H
+#define NODE_POOL_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+// Slab arena for search nodes. A child is built in the scratch slot (the
+// next free slot) and only kept if commit() is called, so rejected
+// duplicates cost nothing. recycle() hands a node that is no longer
+// referenced back for reuse by later children; release() drops every node
+// of a solve at once, keeping the slabs for the next one.
+template <class node_type, size_t slab_nodes = 16384>
+class node_pool
+{
+    static_assert(std::is_trivially_destructible<node_type>::value,
+                  "pooled nodes are released without running destructors");
+
+public:
+    node_pool() {}
+    node_pool(const node_pool &) = delete;
+    node_pool &operator=(const node_pool &) = delete;
+    ~node_pool()
+    {
+        for (node_type *slab : slabs)
+            ::operator delete(slab);
+    }
+
+    // Copies source into the scratch slot. The slot is overwritten by the
+    // next call unless it is committed.
+    node_type *scratch(const node_type &source)
+    {
+        if (!recycled.empty())
+            return new (recycled.back()) node_type(source);
+        if (used == slab_nodes)
+        {
+            current_slab++;
+            used = 0;
+        }
+        if (current_slab == slabs.size())
+            slabs.push_back(static_cast<node_type *>(::operator new(slab_nodes * sizeof(node_type))));
+        return new (slabs[current_slab] + used) node_type(source);
+    }
+
+    void commit()
+    {
+        if (!recycled.empty())
+            recycled.pop_back();
+        else
+            used++;
+        committed++;
+    }
+
+    void recycle(node_type *node)
+    {
+        recycled.push_back(node);
+        committed--;
+    }
+
+    void release()
+    {
+        current_slab = 0;
+        used = 0;
+        committed = 0;
+        recycled.clear();
+    }
+
+    size_t size() const
+    {
+        return committed;
+    }
+
+    size_t allocated_bytes() const
+    {
+        return slabs.size() * slab_nodes * sizeof(node_type) + recycled.capacity() * sizeof(node_type *);
+    }
+
+private:
+    std::vector<node_type *> slabs;
+    size_t current_slab = 0;
+    size_t used = 0;
+    size_t committed = 0;
+    std::vector<node_type *> recycled;
+};
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef PACKED_STATE_H
+#define PACKED_STATE_H
+
+#include <cstdint>
+#include <cstddef>
+
+#define MAX_PACKED_SIZE 8
+
+// Smallest field width that holds every tile value of a W x W board:
+// 4 bits up to 4x4, 5 bits for 5x5 and 6 bits up to 8x8.
+constexpr int packed_tile_bits(int size)
+{
+    int bits = 1;
+    while ((1 << bits) < size * size)
+        bits++;
+    return bits < 4 ? 4 : bits;
+}
+
+// Board packed into fixed-width bit fields, one field per cell in row-major
+// order: one 64-bit word for 4x4, two for 5x5, six for 8x8.
+template <int W>
+struct packed_state
+{
+    static constexpr int bits = packed_tile_bits(W);
+    static constexpr int word_count = (W * W * bits + 63) / 64;
+    static constexpr uint64_t mask = (uint64_t(1) << bits) - 1;
+
+    uint64_t words[word_count] = {};
+
+    int get(int index) const
+    {
+        int offset = index * bits;
+        int word = offset >> 6;
+        int shift = offset & 63;
+        uint64_t value = words[word] >> shift;
+        if (word_count > 1 && shift + bits > 64)
+            value |= words[word + 1] << (64 - shift);
+        return int(value & mask);
+    }
+
+    void set(int index, int value)
+    {
+        int offset = index * bits;
+        int word = offset >> 6;
+        int shift = offset & 63;
+        words[word] = (words[word] & ~(mask << shift)) | (uint64_t(value) << shift);
+        if (word_count > 1 && shift + bits > 64)
+        {
+            int spill = 64 - shift;
+            words[word + 1] = (words[word + 1] & ~(mask >> spill)) | (uint64_t(value) >> spill);
+        }
+    }
+
+    bool operator==(const packed_state &other) const
+    {
+        for (int i = 0; i < word_count; i++)
+        {
+            if (words[i] != other.words[i])
+                return false;
+        }
+        return true;
+    }
+
+    bool operator!=(const packed_state &other) const
+    {
+        return !(*this == other);
+    }
+};
+
+template <int W>
+struct packed_state_hash
+{
+    size_t operator()(const packed_state<W> &state) const
+    {
+        // splitmix64 finalizer over each word
+        uint64_t hash = 0x9e3779b97f4a7c15ULL;
+        for (int i = 0; i < packed_state<W>::word_count; i++)
+        {
+            uint64_t x = state.words[i] + hash;
+            x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+            hash = x ^ (x >> 31);
+        }
+        return size_t(hash);
+    }
+};
+
+#endif
@@ -0,0 +1,242 @@
+#ifndef PARALLEL_IDA_STAR_H
+#define PARALLEL_IDA_STAR_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "ida_star.h"
+#include "move_pruning.h"
+#include "path_store.h"
+#include "search_node.h"
+
+// Parallel IDA*: the tree is cut at a shallow frontier, found once by a
+// breadth-first walk along the move pruning automaton until there are
+// tasks_per_thread tasks for every thread or max_split_depth moves. Every
+// iteration deals the frontier round-robin onto per-thread deques; a
+// thread runs its own tasks from the front, in the order sequential IDA*
+// would visit them, and when it runs dry steals from the back of the
+// others', the tasks their owners would reach last. Each task is an
+// ordinary cost-bounded pass of ida_star_solver, the next bound is the
+// atomic minimum of what the passes saw, and the first goal sets a flag
+// every pass polls, so the others unwind at once. A goal found under bound
+// costs exactly bound, so the first one is optimal.
+
+template <int W, class heuristic>
+class parallel_ida_star_solver
+{
+public:
+    typedef search_node<W> node_type;
+
+    long long explored_node = 0;
+    long long expanded_node = 0;
+    long long stolen_task = 0;
+    std::vector<long long> thread_expanded;
+    size_t task_count = 0;
+    int split_depth = 0;
+
+    explicit parallel_ida_star_solver(int thread_count_, size_t tasks_per_thread_ = 64, int max_split_depth_ = 12)
+        : thread_count(thread_count_ > 0 ? thread_count_ : 1),
+          tasks_per_thread(tasks_per_thread_),
+          max_split_depth(max_split_depth_),
+          workers(thread_count)
+    {
+        for (worker &self : workers)
+            self.solver.stop = &found;
+    }
+
+    bool solve(node_type node, std::vector<int> &path)
+    {
+        node.g_n = 0;
+        evaluate<W, heuristic>(node);
+        explored_node++;
+        bool solved = split(node, path);
+        double bound = node.priority_value;
+        while (!solved && !tasks.empty())
+        {
+            double next_bound;
+            solved = run_iteration(bound, path, next_bound);
+            if (next_bound == INFINITY)
+                break;
+            bound = next_bound;
+        }
+
+        thread_expanded.assign(thread_count, 0);
+        for (int id = 0; id < thread_count; id++)
+        {
+            thread_expanded[id] = workers[id].solver.expanded_node;
+            expanded_node += workers[id].solver.expanded_node;
+            explored_node += workers[id].solver.explored_node;
+            stolen_task += workers[id].stolen;
+        }
+        return solved;
+    }
+
+    // The frontier and its path records plus one board and move stack per
+    // thread, each as deep as its passes went.
+    size_t peak_bytes() const
+    {
+        size_t bytes = tasks.capacity() * sizeof(task) + paths.bytes();
+        for (const worker &self : workers)
+            bytes += sizeof(node_type) + self.solver.deepest_path * sizeof(int);
+        return bytes;
+    }
+
+private:
+    struct task
+    {
+        node_type node;
+        int pruning_state;
+        uint32_t path_index; // record of the moves from the start
+    };
+
+    struct worker
+    {
+        ida_star_solver<W, heuristic> solver;
+        std::mutex lock;
+        std::deque<uint32_t> queue; // task indices
+        long long stolen = 0;
+    };
+
+    int thread_count;
+    size_t tasks_per_thread;
+    int max_split_depth;
+    std::vector<worker> workers;
+    std::vector<task> tasks;
+    path_store paths;
+
+    std::atomic<bool> found{false};
+    std::atomic<double> shared_next_bound{INFINITY};
+    std::mutex solution_lock;
+    std::vector<int> solution;
+
+    // Breadth-first down to the frontier. A goal on the way is reached at
+    // its smallest depth, so it is returned as the optimal path.
+    bool split(const node_type &start, std::vector<int> &path)
+    {
+        const packed_state<W> correct_configuration = goal_state<W>();
+        const move_pruning_automaton &pruning = move_pruning();
+        path.clear();
+        if (start.board == correct_configuration)
+            return true;
+        std::vector<task> next;
+        tasks.assign(1, {start, move_pruning_automaton::start, path_store::root});
+        size_t wanted = tasks_per_thread * thread_count;
+        for (split_depth = 0; split_depth < max_split_depth && tasks.size() < wanted && !tasks.empty(); split_depth++)
+        {
+            next.clear();
+            for (const task &parent : tasks)
+            {
+                expanded_node++;
+                for (int move = 0; move < MOVE_COUNT; move++)
+                {
+                    int next_state = pruning.next(parent.pruning_state, move);
+                    if (next_state < 0)
+                        continue;
+                    int target = tables<W>.move_target[parent.node.blank][move];
+                    if (target < 0)
+                        continue;
+                    explored_node++;
+                    task child = parent;
+                    move_blank<W, heuristic>(child.node, target);
+                    child.pruning_state = next_state;
+                    child.path_index = paths.add(parent.path_index, move);
+                    if (child.node.board == correct_configuration)
+                    {
+                        path = paths.moves(child.path_index);
+                        return true;
+                    }
+                    next.push_back(child);
+                }
+            }
+            tasks.swap(next);
+        }
+        task_count = tasks.size();
+        return false;
+    }
+
+    bool run_iteration(double bound, std::vector<int> &path, double &next_bound)
+    {
+        for (size_t index = 0; index < tasks.size(); index++)
+            workers[index % thread_count].queue.push_back(uint32_t(index));
+        found = false;
+        shared_next_bound = INFINITY;
+
+        std::vector<std::thread> threads;
+        for (int id = 1; id < thread_count; id++)
+            threads.emplace_back(&parallel_ida_star_solver::work, this, id, bound);
+        work(0, bound);
+        for (std::thread &thread : threads)
+            thread.join();
+
+        for (worker &self : workers)
+            self.queue.clear(); // left over after a goal
+        next_bound = shared_next_bound;
+        if (!found)
+            return false;
+        path = solution;
+        return true;
+    }
+
+    void work(int id, double bound)
+    {
+        worker &self = workers[id];
+        std::vector<int> moves;
+        double next_bound = INFINITY;
+        uint32_t index;
+        while (!found.load(std::memory_order_relaxed) && take(id, index))
+        {
+            node_type node = tasks[index].node;
+            moves.clear();
+            if (self.solver.search(node, bound, tasks[index].pruning_state, moves, next_bound))
+            {
+                std::lock_guard<std::mutex> guard(solution_lock);
+                if (!found)
+                {
+                    solution = paths.moves(tasks[index].path_index);
+                    solution.insert(solution.end(), moves.begin(), moves.end());
+                    found = true;
+                }
+                break;
+            }
+        }
+        double seen = shared_next_bound.load();
+        while (next_bound < seen && !shared_next_bound.compare_exchange_weak(seen, next_bound))
+            ;
+    }
+
+    // Own tasks come off the front; stolen ones off the back of the next
+    // non-empty deque.
+    bool take(int id, uint32_t &index)
+    {
+        worker &self = workers[id];
+        {
+            std::lock_guard<std::mutex> guard(self.lock);
+            if (!self.queue.empty())
+            {
+                index = self.queue.front();
+                self.queue.pop_front();
+                return true;
+            }
+        }
+        for (int offset = 1; offset < thread_count; offset++)
+        {
+            worker &victim = workers[(id + offset) % thread_count];
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if (!victim.queue.empty())
+            {
+                index = victim.queue.back();
+                victim.queue.pop_back();
+                self.stolen++;
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+#endif
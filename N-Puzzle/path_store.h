@@ -0,0 +1,65 @@
+#ifndef PATH_STORE_H
+#define PATH_STORE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// Search tree edges as 4-byte records: the index of the predecessor's
+// record and the 2-bit blank move that led here. A node only carries the
+// index of its own record, so a solution is rebuilt by walking the records
+// back to the root and replaying the moves from the start board, and
+// expanded nodes need not be kept alive for it. Record 0 is the root;
+// indices have 30 bits, and running out of them aborts rather than
+// rebuilding a wrong path.
+class path_store
+{
+public:
+    static constexpr uint32_t root = 0;
+
+    void clear()
+    {
+        records.assign(1, 0);
+    }
+
+    static constexpr size_t max_records = size_t(1) << 30;
+
+    uint32_t add(uint32_t predecessor, int move)
+    {
+        if (records.size() >= max_records)
+        {
+            std::cerr << "path store full: more than 2^30 search tree edges" << std::endl;
+            abort();
+        }
+        records.push_back(predecessor << 2 | uint32_t(move));
+        return uint32_t(records.size() - 1);
+    }
+
+    // Blank moves from the root to the record at index.
+    std::vector<int> moves(uint32_t index) const
+    {
+        std::vector<int> path;
+        for (; index != root; index = records[index] >> 2)
+            path.push_back(records[index] & 3);
+        std::reverse(path.begin(), path.end());
+        return path;
+    }
+
+    size_t size() const
+    {
+        return records.size();
+    }
+
+    size_t bytes() const
+    {
+        return records.capacity() * sizeof(uint32_t);
+    }
+
+private:
+    std::vector<uint32_t> records = std::vector<uint32_t>(1, 0);
+};
+
+#endif
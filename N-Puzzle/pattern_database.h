@@ -0,0 +1,351 @@
+#ifndef PATTERN_DATABASE_H
+#define PATTERN_DATABASE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Additive disjoint pattern databases. Each table stores, for every
+// placement of its pattern tiles, the minimum number of moves of those tiles
+// needed to bring them home (moves of other tiles are free). Tables over
+// disjoint tile sets can therefore be summed.
+
+#define PDB_MAGIC 0x4244504e // "NPDB"
+#define PDB_VERSION 1
+#define PDB_MAX_TILES 32
+#define PDB_DIRECTORY "pdb"
+
+struct pdb_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;
+    uint32_t tile_count;
+    uint32_t entry_bits; // 4 (two entries per byte) or 8
+    uint32_t max_value;
+    uint64_t entries;
+    uint8_t tiles[PDB_MAX_TILES];
+};
+
+inline uint64_t permutation_count(int cell_count, int k)
+{
+    uint64_t count = 1;
+    for (int i = 0; i < k; i++)
+        count *= cell_count - i;
+    return count;
+}
+
+// Perfect hash of k distinct cells out of cell_count: the mixed-radix
+// (Lehmer) rank of the k-permutation, in [0, cell_count! / (cell_count - k)!).
+inline uint64_t rank_positions(const int *position, int k, int cell_count)
+{
+    uint64_t rank = 0;
+    for (int i = 0; i < k; i++)
+    {
+        int digit = position[i];
+        for (int j = 0; j < i; j++)
+        {
+            if (position[j] < position[i])
+                digit--;
+        }
+        rank = rank * (cell_count - i) + digit;
+    }
+    return rank;
+}
+
+inline std::string pattern_database_path(const std::string &directory, int size, const std::vector<int> &tiles)
+{
+    std::string path = directory + "/pdb_" + std::to_string(size);
+    for (size_t i = 0; i < tiles.size(); i++)
+        path += (i == 0 ? "_" : "-") + std::to_string(tiles[i]);
+    return path + ".bin";
+}
+
+// 0-1 BFS from the goal over (pattern tile cells, blank cell). Moving the
+// blank onto a pattern tile costs one move, onto any other cell it is free.
+// The result is reduced to the pattern cells alone by taking the minimum
+// over blank cells, which is the first distance each pattern rank is seen at.
+inline std::vector<uint8_t> build_pattern_table(int size, const std::vector<int> &tiles, int &max_value)
+{
+    int cells = size * size;
+    int k = tiles.size();
+    uint64_t blank_radix = cells - k;
+    std::vector<uint8_t> distance(permutation_count(cells, k + 1), 255);
+    std::vector<uint8_t> table(permutation_count(cells, k), 255);
+
+    // states are queued as 6-bit cell fields, pattern tiles first, blank last
+    auto pack = [&](const int *position)
+    {
+        uint64_t packed = 0;
+        for (int i = 0; i <= k; i++)
+            packed |= uint64_t(position[i]) << (6 * i);
+        return packed;
+    };
+
+    int position[PDB_MAX_TILES + 1];
+    for (int i = 0; i < k; i++)
+        position[i] = tiles[i] - 1;
+    position[k] = cells - 1;
+    distance[rank_positions(position, k + 1, cells)] = 0;
+
+    std::vector<uint64_t> current(1, pack(position)), next;
+    max_value = 0;
+    for (int depth = 0; !current.empty(); depth++)
+    {
+        // free moves stay in this layer, so the layer is worked as a stack
+        while (!current.empty())
+        {
+            uint64_t packed = current.back();
+            current.pop_back();
+            for (int i = 0; i <= k; i++)
+                position[i] = (packed >> (6 * i)) & 63;
+            uint64_t rank = rank_positions(position, k + 1, cells);
+            if (distance[rank] != depth)
+                continue; // improved later through a free move
+            uint8_t &entry = table[rank / blank_radix];
+            if (entry == 255)
+            {
+                entry = depth;
+                max_value = depth;
+            }
+
+            int blank = position[k];
+            int row = blank / size;
+            int col = blank % size;
+            int neighbours[4];
+            int neighbour_count = 0;
+            if (row > 0)
+                neighbours[neighbour_count++] = blank - size;
+            if (row < size - 1)
+                neighbours[neighbour_count++] = blank + size;
+            if (col > 0)
+                neighbours[neighbour_count++] = blank - 1;
+            if (col < size - 1)
+                neighbours[neighbour_count++] = blank + 1;
+
+            for (int m = 0; m < neighbour_count; m++)
+            {
+                int cell = neighbours[m];
+                int owner = -1;
+                for (int i = 0; i < k; i++)
+                {
+                    if (position[i] == cell)
+                        owner = i;
+                }
+                if (owner >= 0)
+                    position[owner] = blank;
+                position[k] = cell;
+
+                int cost = owner >= 0 ? 1 : 0;
+                uint64_t child = rank_positions(position, k + 1, cells);
+                if (depth + cost < distance[child])
+                {
+                    distance[child] = depth + cost;
+                    (cost ? next : current).push_back(pack(position));
+                }
+
+                if (owner >= 0)
+                    position[owner] = cell;
+                position[k] = blank;
+            }
+        }
+        std::swap(current, next);
+    }
+    return table;
+}
+
+class pattern_database
+{
+public:
+    int size = 0;
+    std::vector<int> tiles;
+    int entry_bits = 8;
+    uint64_t entries = 0;
+    const uint8_t *table = nullptr;
+
+    pattern_database() {}
+    pattern_database(const pattern_database &) = delete;
+    pattern_database &operator=(const pattern_database &) = delete;
+    ~pattern_database()
+    {
+        if (mapping)
+            munmap(mapping, mapping_size);
+    }
+
+    int lookup(uint64_t rank) const
+    {
+        if (entry_bits == 4)
+            return (table[rank >> 1] >> ((rank & 1) * 4)) & 15;
+        return table[rank];
+    }
+
+    // tile_position[t] is the cell tile t sits on
+    int lookup_positions(const int *tile_position) const
+    {
+        int position[PDB_MAX_TILES];
+        for (size_t i = 0; i < tiles.size(); i++)
+            position[i] = tile_position[tiles[i]];
+        return lookup(rank_positions(position, tiles.size(), size * size));
+    }
+
+    static bool write(const std::string &path, int size, const std::vector<int> &tiles,
+                      const std::vector<uint8_t> &table, int max_value)
+    {
+        pdb_header header;
+        memset(&header, 0, sizeof(header));
+        header.magic = PDB_MAGIC;
+        header.version = PDB_VERSION;
+        header.size = size;
+        header.tile_count = tiles.size();
+        header.entry_bits = max_value <= 15 ? 4 : 8;
+        header.max_value = max_value;
+        header.entries = table.size();
+        for (size_t i = 0; i < tiles.size(); i++)
+            header.tiles[i] = tiles[i];
+
+        std::vector<uint8_t> packed;
+        if (header.entry_bits == 4)
+        {
+            packed.assign((table.size() + 1) / 2, 0);
+            for (size_t i = 0; i < table.size(); i++)
+                packed[i >> 1] |= table[i] << ((i & 1) * 4);
+        }
+        const std::vector<uint8_t> &data = header.entry_bits == 4 ? packed : table;
+
+        std::string temporary = path + ".tmp";
+        FILE *file = fopen(temporary.c_str(), "wb");
+        if (!file)
+            return false;
+        bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                  fwrite(data.data(), 1, data.size(), file) == data.size();
+        ok = fclose(file) == 0 && ok;
+        return ok && rename(temporary.c_str(), path.c_str()) == 0;
+    }
+
+    bool load(const std::string &path, int expected_size, const std::vector<int> &expected_tiles)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0 || size_t(info.st_size) < sizeof(pdb_header))
+        {
+            close(fd);
+            return false;
+        }
+        void *base = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (base == MAP_FAILED)
+            return false;
+
+        const pdb_header *header = static_cast<const pdb_header *>(base);
+        uint64_t data_bytes = header->entry_bits == 4 ? (header->entries + 1) / 2 : header->entries;
+        bool valid = header->magic == PDB_MAGIC && header->version == PDB_VERSION &&
+                     int(header->size) == expected_size && header->tile_count == expected_tiles.size() &&
+                     (header->entry_bits == 4 || header->entry_bits == 8) &&
+                     header->entries == permutation_count(expected_size * expected_size, expected_tiles.size()) &&
+                     uint64_t(info.st_size) == sizeof(pdb_header) + data_bytes;
+        for (size_t i = 0; valid && i < expected_tiles.size(); i++)
+            valid = header->tiles[i] == expected_tiles[i];
+        if (!valid)
+        {
+            munmap(base, info.st_size);
+            return false;
+        }
+
+        mapping = base;
+        mapping_size = info.st_size;
+        size = expected_size;
+        tiles = expected_tiles;
+        entry_bits = header->entry_bits;
+        entries = header->entries;
+        table = static_cast<const uint8_t *>(base) + sizeof(pdb_header);
+        return true;
+    }
+
+private:
+    void *mapping = nullptr;
+    size_t mapping_size = 0;
+};
+
+// 6-6-3 for 4x4 and 6-6-6-6 for 5x5, grouped into compact blocks around the
+// goal (blank in the bottom-right corner).
+inline std::vector<std::vector<int>> default_partition(int size)
+{
+    switch (size)
+    {
+    case 2:
+        return {{1, 2, 3}};
+    case 3:
+        return {{1, 2, 3, 4}, {5, 6, 7, 8}};
+    case 4:
+        return {{1, 5, 6, 9, 10, 13}, {7, 8, 11, 12, 14, 15}, {2, 3, 4}};
+    case 5:
+        return {{1, 2, 3, 6, 7, 8}, {4, 5, 9, 10, 14, 15}, {11, 12, 16, 17, 21, 22}, {13, 18, 19, 20, 23, 24}};
+    default:
+        return {};
+    }
+}
+
+class pattern_database_set
+{
+public:
+    std::vector<std::unique_ptr<pattern_database>> patterns;
+    int tile_owner[PDB_MAX_TILES]; // index into patterns
+
+    // Maps the tables for this board size, building and writing any that are
+    // missing or stale first.
+    bool load(int size, const std::string &directory = PDB_DIRECTORY)
+    {
+        patterns.clear();
+        std::vector<std::vector<int>> partition = default_partition(size);
+        if (partition.empty())
+            return false;
+        mkdir(directory.c_str(), 0755);
+
+        for (const std::vector<int> &tiles : partition)
+        {
+            std::string path = pattern_database_path(directory, size, tiles);
+            std::unique_ptr<pattern_database> pdb(new pattern_database());
+            if (!pdb->load(path, size, tiles))
+            {
+                std::cerr << "Building pattern database " << path << std::endl;
+                int max_value;
+                std::vector<uint8_t> table = build_pattern_table(size, tiles, max_value);
+                if (!pattern_database::write(path, size, tiles, table, max_value) ||
+                    !pdb->load(path, size, tiles))
+                {
+                    std::cerr << "cannot write pattern database " << path << std::endl;
+                    return false;
+                }
+            }
+            for (int tile : tiles)
+                tile_owner[tile] = patterns.size();
+            patterns.push_back(std::move(pdb));
+        }
+        return true;
+    }
+
+    int distance(const int *tile_position) const
+    {
+        int total = 0;
+        for (const auto &pdb : patterns)
+            total += pdb->lookup_positions(tile_position);
+        return total;
+    }
+
+    const pattern_database &owner(int tile) const
+    {
+        return *patterns[tile_owner[tile]];
+    }
+};
+
+#endif
@@ -0,0 +1,448 @@
+#ifndef PDB_BUILDER_H
+#define PDB_BUILDER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+#include "pattern_database.h"
+
+// Multi-threaded construction of the tables build_pattern_table makes, for
+// prebuilding pdb/ before deployment. The 0-1 BFS runs one cost layer at a
+// time: threads take chunks of the layer's frontier and follow free moves
+// depth-first from each state, claiming states in a shared visited bitmap
+// (one atomic bit per pattern-and-blank rank) and filling the pattern
+// entries (atomic bytes per pattern rank) with the layer number. Costly
+// moves only leave candidates in per-thread buffers; once the whole layer
+// is closed, each thread claims its still unvisited candidates as the next
+// frontier. A state is therefore always claimed at its exact distance, and
+// a pattern entry at the first layer that reaches it, the minimum over
+// blank cells.
+//
+// With a checkpoint directory, the bitmap, the entries and the frontier are
+// saved after every layer and an interrupted build resumes from the last
+// one. The finished table is verified before it is written: every
+// placement was reached, the goal placement is the only zero, and every
+// other entry has a one-tile move to a smaller one (the first costly move
+// of an optimal path).
+
+#define PDB_CHECKPOINT_MAGIC 0x4b43504e // "NPCK"
+#define PDB_CHECKPOINT_VERSION 1
+
+struct pdb_checkpoint_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;
+    uint32_t tile_count;
+    uint32_t depth;     // layer of the saved frontier
+    uint32_t reserved;
+    uint64_t frontier;  // packed states that follow the tables
+    uint8_t tiles[PDB_MAX_TILES];
+};
+
+struct pdb_build_options
+{
+    int threads = 1;
+    std::string checkpoint_directory; // no checkpoints when empty
+};
+
+// Inverse of rank_positions.
+inline void unrank_positions(uint64_t rank, int k, int cell_count, int *position)
+{
+    int digit[PDB_MAX_TILES + 1];
+    for (int i = k - 1; i >= 0; i--)
+    {
+        digit[i] = int(rank % (cell_count - i));
+        rank /= cell_count - i;
+    }
+    bool used[64] = {};
+    for (int i = 0; i < k; i++)
+    {
+        int cell = 0;
+        for (int skip = digit[i];; cell++)
+        {
+            if (!used[cell] && skip-- == 0)
+                break;
+        }
+        used[cell] = true;
+        position[i] = cell;
+    }
+}
+
+template <class function>
+void run_threads(int thread_count, const function &work)
+{
+    std::vector<std::thread> threads;
+    for (int id = 1; id < thread_count; id++)
+        threads.emplace_back(work, id);
+    work(0);
+    for (std::thread &thread : threads)
+        thread.join();
+}
+
+class pattern_table_builder
+{
+public:
+    bool resumed = false;
+    int layers = 0;
+
+    pattern_table_builder(int size_, const std::vector<int> &tiles_, const pdb_build_options &options)
+        : size(size_), cells(size_ * size_), k(int(tiles_.size())), tiles(tiles_),
+          thread_count(std::max(1, options.threads)),
+          state_count(permutation_count(cells, k + 1)),
+          entry_count(permutation_count(cells, k)),
+          blank_radix(cells - k),
+          visited(new std::atomic<uint64_t>[(state_count + 63) / 64]),
+          entries(new std::atomic<uint8_t>[entry_count]),
+          buffers(thread_count)
+    {
+        if (!options.checkpoint_directory.empty())
+        {
+            checkpoint_path = pattern_database_path(options.checkpoint_directory, size, tiles);
+            checkpoint_path.replace(checkpoint_path.size() - 4, 4, ".ckpt");
+        }
+    }
+
+    // Same table and max_value as build_pattern_table.
+    std::vector<uint8_t> build(int &max_value)
+    {
+        int depth = 0;
+        if (checkpoint_path.empty() || !read_checkpoint(depth))
+        {
+            for (uint64_t i = 0; i < (state_count + 63) / 64; i++)
+                visited[i].store(0, std::memory_order_relaxed);
+            for (uint64_t i = 0; i < entry_count; i++)
+                entries[i].store(255, std::memory_order_relaxed);
+            int position[PDB_MAX_TILES + 1];
+            for (int i = 0; i < k; i++)
+                position[i] = tiles[i] - 1;
+            position[k] = cells - 1;
+            uint64_t rank = rank_positions(position, k + 1, cells);
+            claim(rank);
+            entries[rank / blank_radix].store(0, std::memory_order_relaxed);
+            frontier.assign(1, pack(position));
+        }
+
+        for (; !frontier.empty(); depth++)
+        {
+            close_layer(depth);
+            next_frontier(depth + 1);
+            if (!checkpoint_path.empty() && !write_checkpoint(depth + 1))
+                std::cerr << "cannot write checkpoint " << checkpoint_path << std::endl;
+        }
+        layers = depth;
+        if (!checkpoint_path.empty())
+            remove(checkpoint_path.c_str());
+
+        std::vector<uint8_t> table(entry_count);
+        max_value = 0;
+        for (uint64_t i = 0; i < entry_count; i++)
+        {
+            table[i] = entries[i].load(std::memory_order_relaxed);
+            if (table[i] != 255)
+                max_value = std::max(max_value, int(table[i]));
+        }
+        return table;
+    }
+
+    static bool verify(int size, const std::vector<int> &tiles, const std::vector<uint8_t> &table, int thread_count)
+    {
+        int cells = size * size;
+        int k = int(tiles.size());
+        int goal[PDB_MAX_TILES];
+        for (int i = 0; i < k; i++)
+            goal[i] = tiles[i] - 1;
+        uint64_t goal_rank = rank_positions(goal, k, cells);
+        // a pattern of every tile only reaches half of its placements
+        bool complete = k == cells - 1;
+        std::atomic<bool> ok{table.size() == permutation_count(cells, k)};
+        thread_count = std::max(1, thread_count);
+        run_threads(thread_count, [&](int id)
+        {
+            int position[PDB_MAX_TILES];
+            static const int row_step[4] = {-1, 1, 0, 0};
+            static const int col_step[4] = {0, 0, -1, 1};
+            for (uint64_t rank = id; rank < table.size() && ok.load(std::memory_order_relaxed); rank += thread_count)
+            {
+                int value = table[rank];
+                if (value == 255 && complete)
+                    continue; // the other permutation parity
+                if (value == 255 || (value == 0) != (rank == goal_rank))
+                {
+                    ok = false;
+                    break;
+                }
+                if (value == 0)
+                    continue;
+                unrank_positions(rank, k, cells, position);
+                bool occupied[64] = {};
+                for (int i = 0; i < k; i++)
+                    occupied[position[i]] = true;
+                bool descends = false;
+                for (int i = 0; i < k && !descends; i++)
+                {
+                    int cell = position[i];
+                    for (int move = 0; move < 4 && !descends; move++)
+                    {
+                        int row = cell / size + row_step[move], col = cell % size + col_step[move];
+                        if (row < 0 || row >= size || col < 0 || col >= size || occupied[row * size + col])
+                            continue;
+                        position[i] = row * size + col;
+                        descends = table[rank_positions(position, k, cells)] < value;
+                        position[i] = cell;
+                    }
+                }
+                if (!descends)
+                    ok = false;
+            }
+        });
+        return ok;
+    }
+
+private:
+    int size, cells, k;
+    std::vector<int> tiles;
+    int thread_count;
+    uint64_t state_count, entry_count, blank_radix;
+    std::unique_ptr<std::atomic<uint64_t>[]> visited;
+    std::unique_ptr<std::atomic<uint8_t>[]> entries;
+    std::vector<uint64_t> frontier; // states as 6-bit cell fields, as in build_pattern_table
+    std::vector<std::vector<uint64_t>> buffers; // per-thread candidates, then next frontier
+    std::string checkpoint_path;
+
+    uint64_t pack(const int *position) const
+    {
+        uint64_t packed = 0;
+        for (int i = 0; i <= k; i++)
+            packed |= uint64_t(position[i]) << (6 * i);
+        return packed;
+    }
+
+    void unpack(uint64_t packed, int *position) const
+    {
+        for (int i = 0; i <= k; i++)
+            position[i] = (packed >> (6 * i)) & 63;
+    }
+
+    bool seen(uint64_t rank) const
+    {
+        return visited[rank >> 6].load(std::memory_order_relaxed) >> (rank & 63) & 1;
+    }
+
+    // True for the one thread that sets the bit.
+    bool claim(uint64_t rank)
+    {
+        uint64_t bit = uint64_t(1) << (rank & 63);
+        return !seen(rank) && !(visited[rank >> 6].fetch_or(bit, std::memory_order_relaxed) & bit);
+    }
+
+    void set_entry(uint64_t rank, int depth)
+    {
+        std::atomic<uint8_t> &entry = entries[rank / blank_radix];
+        if (entry.load(std::memory_order_relaxed) == 255)
+            entry.store(uint8_t(depth), std::memory_order_relaxed); // racing writers store the same layer
+    }
+
+    // Claims everything reachable from the frontier by free moves and
+    // collects the costly moves' unvisited children in the buffers.
+    void close_layer(int depth)
+    {
+        std::atomic<size_t> next_chunk{0};
+        const size_t chunk = 256;
+        run_threads(thread_count, [&](int id)
+        {
+            std::vector<uint64_t> &candidates = buffers[id];
+            std::vector<uint64_t> stack;
+            int position[PDB_MAX_TILES + 1];
+            candidates.clear();
+            size_t begin;
+            while ((begin = next_chunk.fetch_add(chunk)) < frontier.size())
+            {
+                size_t end = std::min(frontier.size(), begin + chunk);
+                stack.assign(frontier.begin() + begin, frontier.begin() + end);
+                while (!stack.empty())
+                {
+                    unpack(stack.back(), position);
+                    stack.pop_back();
+                    int blank = position[k];
+                    int row = blank / size, col = blank % size;
+                    int neighbours[4];
+                    int neighbour_count = 0;
+                    if (row > 0)
+                        neighbours[neighbour_count++] = blank - size;
+                    if (row < size - 1)
+                        neighbours[neighbour_count++] = blank + size;
+                    if (col > 0)
+                        neighbours[neighbour_count++] = blank - 1;
+                    if (col < size - 1)
+                        neighbours[neighbour_count++] = blank + 1;
+
+                    for (int m = 0; m < neighbour_count; m++)
+                    {
+                        int cell = neighbours[m];
+                        int owner = -1;
+                        for (int i = 0; i < k; i++)
+                        {
+                            if (position[i] == cell)
+                                owner = i;
+                        }
+                        if (owner >= 0)
+                            position[owner] = blank;
+                        position[k] = cell;
+
+                        uint64_t child = rank_positions(position, k + 1, cells);
+                        if (owner >= 0)
+                        {
+                            if (!seen(child))
+                                candidates.push_back(pack(position));
+                        }
+                        else if (claim(child))
+                        {
+                            set_entry(child, depth);
+                            stack.push_back(pack(position));
+                        }
+
+                        if (owner >= 0)
+                            position[owner] = cell;
+                        position[k] = blank;
+                    }
+                }
+            }
+        });
+    }
+
+    void next_frontier(int depth)
+    {
+        run_threads(thread_count, [&](int id)
+        {
+            std::vector<uint64_t> &buffer = buffers[id];
+            int position[PDB_MAX_TILES + 1];
+            size_t kept = 0;
+            for (uint64_t packed : buffer)
+            {
+                unpack(packed, position);
+                uint64_t rank = rank_positions(position, k + 1, cells);
+                if (claim(rank))
+                {
+                    set_entry(rank, depth);
+                    buffer[kept++] = packed;
+                }
+            }
+            buffer.resize(kept);
+        });
+        frontier.clear();
+        for (std::vector<uint64_t> &buffer : buffers)
+        {
+            frontier.insert(frontier.end(), buffer.begin(), buffer.end());
+            std::vector<uint64_t>().swap(buffer);
+        }
+    }
+
+    bool write_checkpoint(int depth) const
+    {
+        pdb_checkpoint_header header;
+        memset(&header, 0, sizeof(header));
+        header.magic = PDB_CHECKPOINT_MAGIC;
+        header.version = PDB_CHECKPOINT_VERSION;
+        header.size = size;
+        header.tile_count = k;
+        header.depth = depth;
+        header.frontier = frontier.size();
+        for (int i = 0; i < k; i++)
+            header.tiles[i] = tiles[i];
+
+        mkdir(checkpoint_path.substr(0, checkpoint_path.rfind('/')).c_str(), 0755);
+        std::string temporary = checkpoint_path + ".tmp";
+        FILE *file = fopen(temporary.c_str(), "wb");
+        if (!file)
+            return false;
+        // std::atomic of an integer has its size and layout
+        uint64_t words = (state_count + 63) / 64;
+        bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                  fwrite(visited.get(), sizeof(uint64_t), words, file) == words &&
+                  fwrite(entries.get(), 1, entry_count, file) == entry_count &&
+                  fwrite(frontier.data(), sizeof(uint64_t), frontier.size(), file) == frontier.size();
+        ok = fclose(file) == 0 && ok;
+        return ok && rename(temporary.c_str(), checkpoint_path.c_str()) == 0;
+    }
+
+    bool read_checkpoint(int &depth)
+    {
+        FILE *file = fopen(checkpoint_path.c_str(), "rb");
+        if (!file)
+            return false;
+        pdb_checkpoint_header header;
+        bool ok = fread(&header, sizeof(header), 1, file) == 1 && header.magic == PDB_CHECKPOINT_MAGIC &&
+                  header.version == PDB_CHECKPOINT_VERSION && int(header.size) == size &&
+                  int(header.tile_count) == k;
+        for (int i = 0; ok && i < k; i++)
+            ok = header.tiles[i] == tiles[i];
+        if (ok)
+        {
+            uint64_t words = (state_count + 63) / 64;
+            frontier.resize(header.frontier);
+            ok = fread(visited.get(), sizeof(uint64_t), words, file) == words &&
+                 fread(entries.get(), 1, entry_count, file) == entry_count &&
+                 fread(frontier.data(), sizeof(uint64_t), frontier.size(), file) == frontier.size() &&
+                 fgetc(file) == EOF;
+        }
+        fclose(file);
+        if (!ok)
+            return false;
+        depth = header.depth;
+        resumed = true;
+        std::cerr << "Resuming " << checkpoint_path << " at layer " << depth << std::endl;
+        return true;
+    }
+};
+
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t) && sizeof(std::atomic<uint8_t>) == 1,
+              "checkpoints copy the atomic arrays as plain integers");
+
+// Builds, verifies and writes every table of the default partition for
+// size that is missing or stale in directory; the solver then maps them as
+// usual.
+inline bool build_pattern_databases(int size, const pdb_build_options &options,
+                                    const std::string &directory = PDB_DIRECTORY)
+{
+    std::vector<std::vector<int>> partition = default_partition(size);
+    if (partition.empty())
+        return false;
+    mkdir(directory.c_str(), 0755);
+    for (const std::vector<int> &tiles : partition)
+    {
+        std::string path = pattern_database_path(directory, size, tiles);
+        pattern_database existing;
+        if (existing.load(path, size, tiles))
+        {
+            std::cerr << path << " is up to date" << std::endl;
+            continue;
+        }
+        std::cerr << "Building pattern database " << path << " on " << options.threads << " threads" << std::endl;
+        pattern_table_builder builder(size, tiles, options);
+        int max_value;
+        std::vector<uint8_t> table = builder.build(max_value);
+        if (!pattern_table_builder::verify(size, tiles, table, options.threads))
+        {
+            std::cerr << "verification failed for " << path << std::endl;
+            return false;
+        }
+        if (!pattern_database::write(path, size, tiles, table, max_value) || !existing.load(path, size, tiles))
+        {
+            std::cerr << "cannot write pattern database " << path << std::endl;
+            return false;
+        }
+        std::cerr << path << ": " << builder.layers << " layers, max " << max_value << ", verified" << std::endl;
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,481 @@
+#ifndef REALTIME_SOLVER_H
+#define REALTIME_SOLVER_H
+
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <istream>
+#include <vector>
+#include "distance_table.h"
+#include "search_node.h"
+
+// Suboptimal real-time solver for boards of any width from 3 up, where
+// optimal search is out of reach. The unsolved region shrinks one line at
+// a time, its top row or left column, whichever is longer, until 3x3 is
+// left:
+//
+// - all but the last two tiles of the line are walked to their cells one
+//   step at a time, each step moving the blank around the tile (avoiding
+//   solved cells) to the next cell on the tile's shortest path;
+// - of the last two, the one for the far end is brought to the near end's
+//   cell, the other into the 3x3 window at the end of the line, and the
+//   blank into the window; a breadth-first search over the two tiles and
+//   the blank inside the window (at most 512 states) then finishes the
+//   line without the usual special cases;
+// - the last 3x3 is finished optimally by descending the 8-puzzle
+//   distance table.
+//
+// step() returns one move at a time and plans at most one such unit when
+// it runs out of planned moves: a few breadth-first searches over the
+// board, one window search or one table descent. The work per move is
+// therefore bounded by O(n^2) however the board looks. Measured on random
+// 30x30 boards, the slowest move takes about 60-120 us and the mean is
+// under 1 us; the bound is structural, not a wall-clock guarantee.
+// eight_puzzle_table must be loaded first.
+
+class realtime_solver
+{
+public:
+    explicit realtime_solver(int n_)
+        : n(n_), cells(n_ * n_), tile_at(cells), cell_of(cells), locked(cells, 0),
+          target_distance(cells), blank_parent(cells), queue(cells), blank_seen(cells, 0)
+    {
+    }
+
+    // Reads the n * n tiles after the size.
+    bool read(std::istream &in)
+    {
+        std::vector<char> seen(cells, 0);
+        for (int cell = 0; cell < cells; cell++)
+        {
+            int tile;
+            if (!(in >> tile) || tile < 0 || tile >= cells || seen[tile])
+                return false;
+            seen[tile] = 1;
+            tile_at[cell] = tile;
+            cell_of[tile] = cell;
+        }
+        return true;
+    }
+
+    // Inversions by a Fenwick tree, then the same rule as solvable().
+    bool solvable() const
+    {
+        std::vector<int> tree(cells, 0);
+        long long inversions = 0;
+        int count = 0;
+        for (int cell = 0; cell < cells; cell++)
+        {
+            int tile = tile_at[cell];
+            if (tile == 0)
+                continue;
+            int smaller = 0;
+            for (int i = tile; i > 0; i -= i & -i)
+                smaller += tree[i];
+            inversions += count++ - smaller;
+            for (int i = tile; i < cells; i += i & -i)
+                tree[i]++;
+        }
+        if (n % 2 != 0)
+            return inversions % 2 == 0;
+        int row_from_bottom = n - cell_of[0] / n;
+        return (inversions % 2 != 0) == (row_from_bottom % 2 == 0);
+    }
+
+    bool solved() const
+    {
+        for (int cell = 0; cell + 1 < cells; cell++)
+        {
+            if (tile_at[cell] != cell + 1)
+                return false;
+        }
+        return true;
+    }
+
+    // The next blank move (0 up, 1 down, 2 left, 3 right), applied to the
+    // board; -1 once the board is solved or if planning failed.
+    int step()
+    {
+        while (planned.empty())
+        {
+            if (failed || !plan())
+                return -1;
+        }
+        int move = planned.front();
+        planned.pop_front();
+        apply(move);
+        return move;
+    }
+
+    bool failed = false;
+
+private:
+    // a line's last two tiles
+    struct line_end
+    {
+        int tile_a, cell_a, tile_b, cell_b;
+        int below_a;             // next to cell_a, one line further
+        std::vector<int> window; // 3x3 minus the solved cell before cell_a
+        int phase = 0;
+    };
+
+    int n, cells;
+    std::vector<int> tile_at, cell_of;
+    std::vector<char> locked; // solved cells, and cells held for the line end
+    std::deque<int> planned;  // blank moves not yet made
+    int top = 0, left = 0;    // the unsolved region is rows top.. and columns left..
+
+    // current line: cells to fill in order, then its end
+    std::vector<int> line_cells;
+    size_t next_in_line = 0;
+    line_end end;
+    bool have_line = false;
+    bool finishing = false;
+    int finish_distance = -1;
+
+    std::vector<int> target_distance, blank_parent, queue;
+    std::vector<unsigned> blank_seen; // cells reached by the blank search stamped blank_stamp
+    unsigned blank_stamp = 0;
+    int distance_target = -1; // target_distance is valid for this cell and the current locks
+    int tile_steps = 0;
+
+    int offset(int move) const
+    {
+        static const int row_step[MOVE_COUNT] = {-1, 1, 0, 0};
+        static const int col_step[MOVE_COUNT] = {0, 0, -1, 1};
+        return row_step[move] * n + col_step[move];
+    }
+
+    // neighbour of cell in direction move, -1 off the board
+    int neighbour(int cell, int move) const
+    {
+        int row = cell / n, col = cell % n;
+        if ((move == 0 && row == 0) || (move == 1 && row == n - 1) || (move == 2 && col == 0) ||
+            (move == 3 && col == n - 1))
+            return -1;
+        return cell + offset(move);
+    }
+
+    void apply(int move)
+    {
+        int blank = cell_of[0];
+        int target = blank + offset(move);
+        int tile = tile_at[target];
+        tile_at[blank] = tile;
+        cell_of[tile] = blank;
+        tile_at[target] = 0;
+        cell_of[0] = target;
+    }
+
+    bool adjacent(int cell, int other) const
+    {
+        int distance = abs(cell - other);
+        return distance == n || (distance == 1 && cell / n == other / n);
+    }
+
+    void lock(int cell, char value)
+    {
+        locked[cell] = value;
+        distance_target = -1;
+    }
+
+    // Breadth-first distances from target over unlocked cells.
+    void target_distances(int target)
+    {
+        std::fill(target_distance.begin(), target_distance.end(), -1);
+        target_distance[target] = 0;
+        size_t head = 0, tail = 0;
+        queue[tail++] = target;
+        while (head < tail)
+        {
+            int cell = queue[head++];
+            for (int move = 0; move < MOVE_COUNT; move++)
+            {
+                int next = neighbour(cell, move);
+                if (next < 0 || locked[next] || target_distance[next] >= 0)
+                    continue;
+                target_distance[next] = target_distance[cell] + 1;
+                queue[tail++] = next;
+            }
+        }
+        distance_target = target;
+    }
+
+    // Breadth-first search for the blank over unlocked cells except avoid,
+    // stopping at the nearest cell where found() holds; -1 if there is
+    // none. The blank usually starts next to where it is needed, so the
+    // search stays small.
+    template <class predicate>
+    int blank_search(int avoid, const predicate &found)
+    {
+        blank_stamp++;
+        int source = cell_of[0];
+        blank_seen[source] = blank_stamp;
+        if (found(source))
+            return source;
+        size_t head = 0, tail = 0;
+        queue[tail++] = source;
+        while (head < tail)
+        {
+            int cell = queue[head++];
+            for (int move = 0; move < MOVE_COUNT; move++)
+            {
+                int next = neighbour(cell, move);
+                if (next < 0 || locked[next] || next == avoid || blank_seen[next] == blank_stamp)
+                    continue;
+                blank_seen[next] = blank_stamp;
+                blank_parent[next] = move;
+                if (found(next))
+                    return next;
+                queue[tail++] = next;
+            }
+        }
+        return -1;
+    }
+
+    // Plans the blank's moves to cell from the last blank search.
+    void plan_blank_path(int cell)
+    {
+        std::vector<int> path;
+        for (int at = cell; at != cell_of[0]; at -= offset(blank_parent[at]))
+            path.push_back(blank_parent[at]);
+        planned.insert(planned.end(), path.rbegin(), path.rend());
+    }
+
+    // True if tile is on target; otherwise plans one step of it along its
+    // shortest path, the blank going round it to the cell ahead first.
+    bool place_step(int tile, int target)
+    {
+        int from = cell_of[tile];
+        if (from == target)
+        {
+            tile_steps = 0;
+            return true;
+        }
+        if (++tile_steps > 4 * cells)
+        {
+            failed = true; // going round in circles
+            return false;
+        }
+        if (distance_target != target)
+            target_distances(target);
+        // the cell ahead on a shortest path, or any cell next to the tile if
+        // the blank cannot get to one
+        auto ahead = [&](int cell)
+        {
+            return adjacent(cell, from) && target_distance[cell] == target_distance[from] - 1;
+        };
+        auto beside = [&](int cell) { return adjacent(cell, from) && target_distance[cell] >= 0; };
+        int best = blank_search(from, ahead);
+        if (best < 0)
+            best = blank_search(from, beside);
+        if (best < 0)
+        {
+            failed = true;
+            return false;
+        }
+        int best_move = 0;
+        while (neighbour(from, best_move) != best)
+            best_move++;
+        plan_blank_path(best);
+        planned.push_back(best_move ^ 1); // the blank steps back onto the tile's cell
+        return false;
+    }
+
+    // Lays out the next line of the region, or the 3x3 finish.
+    void next_line()
+    {
+        int height = n - top, width = n - left;
+        if (height <= 3 && width <= 3)
+        {
+            finishing = true;
+            return;
+        }
+        bool row = height >= width;
+        // (i, j): i counts away from the line, j along it
+        auto cell = [&](int i, int j) { return row ? i * n + j : j * n + i; };
+        int line = row ? top : left, start = row ? left : top;
+        line_cells.clear();
+        for (int j = start; j < n - 2; j++)
+            line_cells.push_back(cell(line, j));
+        next_in_line = 0;
+        end = line_end();
+        end.cell_a = cell(line, n - 2);
+        end.cell_b = cell(line, n - 1);
+        end.tile_a = end.cell_a + 1;
+        end.tile_b = end.cell_b + 1;
+        end.below_a = cell(line + 1, n - 2);
+        for (int i = line; i < line + 3; i++)
+        {
+            for (int j = n - 3; j < n; j++)
+            {
+                if (i != line || j != n - 3)
+                    end.window.push_back(cell(i, j));
+            }
+        }
+        if (row)
+            top++;
+        else
+            left++;
+        have_line = true;
+    }
+
+    // One planning unit. False when there is nothing left to plan.
+    bool plan()
+    {
+        if (finishing)
+            return plan_finish();
+        if (!have_line)
+        {
+            next_line();
+            return true;
+        }
+        if (next_in_line < line_cells.size())
+        {
+            int cell = line_cells[next_in_line];
+            if (place_step(cell + 1, cell))
+            {
+                lock(cell, 1);
+                next_in_line++;
+            }
+            return !failed;
+        }
+        return plan_line_end();
+    }
+
+    bool in_window(int cell) const
+    {
+        return std::find(end.window.begin(), end.window.end(), cell) != end.window.end();
+    }
+
+    bool plan_line_end()
+    {
+        switch (end.phase)
+        {
+        case 0:
+            if (cell_of[end.tile_a] == end.cell_a && cell_of[end.tile_b] == end.cell_b)
+                break;
+            end.phase = 1;
+            return true;
+        case 1:
+            if (place_step(end.tile_b, end.cell_a))
+            {
+                lock(end.cell_a, 1);
+                end.phase = 2;
+            }
+            return !failed;
+        case 2:
+            // a stops as soon as it is inside, before it could shut the
+            // blank in behind the line's last cell
+            if (in_window(cell_of[end.tile_a]))
+            {
+                tile_steps = 0;
+                lock(end.cell_a, 0);
+                end.phase = 3;
+            }
+            else
+                place_step(end.tile_a, end.below_a);
+            return !failed;
+        case 3:
+            if (!in_window(cell_of[0]))
+            {
+                lock(cell_of[end.tile_a], 1);
+                lock(cell_of[end.tile_b], 1);
+                int nearest = blank_search(-1, [&](int cell) { return in_window(cell); });
+                lock(cell_of[end.tile_a], 0);
+                lock(cell_of[end.tile_b], 0);
+                if (nearest < 0)
+                    return !(failed = true);
+                plan_blank_path(nearest);
+            }
+            end.phase = 4;
+            return true;
+        default:
+            if (!plan_window())
+                return !(failed = true);
+        }
+        lock(end.cell_a, 1);
+        lock(end.cell_b, 1);
+        have_line = false;
+        return true;
+    }
+
+    // Breadth-first search over (tile a, tile b, blank) cells inside the
+    // window; the other tiles there are interchangeable.
+    bool plan_window()
+    {
+        const std::vector<int> &window = end.window;
+        int size = int(window.size());
+        auto index = [&](int cell) { return int(std::find(window.begin(), window.end(), cell) - window.begin()); };
+        int goal_a = index(end.cell_a), goal_b = index(end.cell_b);
+        int start = (index(cell_of[end.tile_a]) * size + index(cell_of[end.tile_b])) * size + index(cell_of[0]);
+        std::vector<int> parent(size * size * size, -1), parent_move(size * size * size);
+        std::vector<int> states(1, start);
+        parent[start] = start;
+        int found = -1;
+        for (size_t head = 0; head < states.size() && found < 0; head++)
+        {
+            int state = states[head];
+            int a = state / (size * size), b = state / size % size, blank = state % size;
+            if (a == goal_a && b == goal_b)
+            {
+                found = state;
+                break;
+            }
+            for (int move = 0; move < MOVE_COUNT; move++)
+            {
+                int cell = neighbour(window[blank], move);
+                int next_blank = cell < 0 ? size : index(cell);
+                if (next_blank == size)
+                    continue;
+                int next_a = next_blank == a ? blank : a, next_b = next_blank == b ? blank : b;
+                int next = (next_a * size + next_b) * size + next_blank;
+                if (parent[next] >= 0)
+                    continue;
+                parent[next] = state;
+                parent_move[next] = move;
+                states.push_back(next);
+            }
+        }
+        if (found < 0)
+            return false;
+        std::vector<int> path;
+        for (int state = found; state != start; state = parent[state])
+            path.push_back(parent_move[state]);
+        planned.insert(planned.end(), path.rbegin(), path.rend());
+        return true;
+    }
+
+    // One move of the 3x3 finish, or false once the board is solved.
+    bool plan_finish()
+    {
+        int corner = n - 3;
+        search_node<3> node;
+        for (int i = 0; i < 3; i++)
+        {
+            for (int j = 0; j < 3; j++)
+            {
+                int tile = tile_at[(corner + i) * n + corner + j];
+                int label = 0;
+                if (tile != 0)
+                    label = ((tile - 1) / n - corner) * 3 + (tile - 1) % n - corner + 1;
+                node.board.set(i * 3 + j, label);
+                if (tile == 0)
+                    node.blank = i * 3 + j;
+            }
+        }
+        if (node.board == goal_state<3>())
+            return false;
+        if (finish_distance < 0)
+            finish_distance = eight_puzzle_table.residue(node.board);
+        long long lookups = 0;
+        int move = eight_puzzle_table.descend(node, finish_distance, lookups);
+        if (move < 0)
+            return !(failed = true);
+        finish_distance = (finish_distance + 15) & 15;
+        planned.push_back(move);
+        return true;
+    }
+};
+
+#endif
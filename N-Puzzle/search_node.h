@@ -0,0 +1,277 @@
+#ifndef SEARCH_NODE_H
+#define SEARCH_NODE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "packed_state.h"
+
+// blank moves: up, down, left, right; move ^ 1 is the opposite move
+#define MOVE_COUNT 4
+
+template <int W>
+struct board_tables
+{
+    int goal_row[W * W]; // by tile value, the blank's goal is the last cell
+    int goal_col[W * W];
+    int goal_cell[W * W];
+    int row_of[W * W]; // by cell
+    int col_of[W * W];
+    int move_target[W * W][MOVE_COUNT]; // cell the blank moves to, -1 if off the board
+};
+
+template <int W>
+constexpr board_tables<W> make_board_tables()
+{
+    board_tables<W> tables{};
+    for (int cell = 0; cell < W * W; cell++)
+    {
+        int tile = (cell + 1) % (W * W);
+        tables.goal_row[tile] = cell / W;
+        tables.goal_col[tile] = cell % W;
+        tables.goal_cell[tile] = cell;
+        tables.row_of[cell] = cell / W;
+        tables.col_of[cell] = cell % W;
+        int row = cell / W;
+        int col = cell % W;
+        tables.move_target[cell][0] = row > 0 ? cell - W : -1;
+        tables.move_target[cell][1] = row < W - 1 ? cell + W : -1;
+        tables.move_target[cell][2] = col > 0 ? cell - 1 : -1;
+        tables.move_target[cell][3] = col < W - 1 ? cell + 1 : -1;
+    }
+    return tables;
+}
+
+template <int W>
+inline constexpr board_tables<W> tables = make_board_tables<W>();
+
+// The standard tables with the goal replaced by an arbitrary board, for
+// measuring distances to that board instead.
+template <int W>
+board_tables<W> target_tables(const packed_state<W> &target)
+{
+    board_tables<W> goal = tables<W>;
+    for (int cell = 0; cell < W * W; cell++)
+    {
+        int tile = target.get(cell);
+        goal.goal_row[tile] = cell / W;
+        goal.goal_col[tile] = cell % W;
+        goal.goal_cell[tile] = cell;
+    }
+    return goal;
+}
+
+template <int W>
+packed_state<W> goal_state()
+{
+    packed_state<W> goal;
+    for (int cell = 0; cell < W * W; cell++)
+        goal.set(cell, (cell + 1) % (W * W));
+    return goal;
+}
+
+// True if tiles holds every value 0 .. size - 1 exactly once.
+inline bool is_board_permutation(const std::vector<int> &tiles, size_t size)
+{
+    if (tiles.size() != size)
+        return false;
+    std::vector<char> seen(size, 0);
+    for (int tile : tiles)
+    {
+        if (tile < 0 || size_t(tile) >= size || seen[tile])
+            return false;
+        seen[tile] = 1;
+    }
+    return true;
+}
+
+template <int W>
+class search_node
+{
+public:
+    static constexpr int size = W;
+    packed_state<W> board;
+    double priority_value = 0;
+    int blank = 0;
+    uint32_t heuristic_state = 0; // table indices of indexed heuristics
+    uint32_t path_index = 0;      // record of the move that led here, in the solver's path_store
+    double g_n = 0;
+    double h_n = 0;
+
+public:
+    bool read(std::istream &in)
+    {
+        std::vector<int> tiles(W * W);
+        for (int &tile : tiles)
+        {
+            if (!(in >> tile))
+                return false;
+        }
+        if (!is_board_permutation(tiles, W * W))
+            return false;
+        for (int cell = 0; cell < W * W; cell++)
+        {
+            board.set(cell, tiles[cell]);
+            if (tiles[cell] == 0)
+                blank = cell;
+        }
+        return true;
+    }
+    int tile_at(int row, int col) const
+    {
+        return board.get(row * W + col);
+    }
+    void print_current_configuration(std::ostream &out = std::cout) const
+    {
+        for (int i = 0; i < W; i++)
+        {
+            for (int j = 0; j < W; j++)
+            {
+                out << tile_at(i, j) << " ";
+            }
+            out << std::endl;
+        }
+    }
+};
+
+template <int W>
+int count_inversions(const packed_state<W> &board)
+{
+    int config[W * W];
+    int count = 0;
+    int inversions = 0;
+    for (int cell = 0; cell < W * W; cell++)
+    {
+        int val = board.get(cell);
+        if (val != 0)
+            config[count++] = val;
+    }
+    for (int i = 0; i < count - 1; i++)
+    {
+        for (int j = i + 1; j < count; j++)
+        {
+            if (config[i] > config[j])
+                inversions++;
+        }
+    }
+    return inversions;
+}
+
+template <int W>
+bool solvable(const search_node<W> &node)
+{
+    int inversions = count_inversions(node.board);
+
+    // Solvability condition
+    if (W % 2 != 0)
+        return inversions % 2 == 0;
+    else
+    {
+        int row_from_bottom = W - tables<W>.row_of[node.blank];
+        if (row_from_bottom % 2 == 0) // empty tile is on an even row from the bottom
+        {
+            return inversions % 2 != 0;
+        }
+        else // empty tile is on an odd row from the bottom
+        {
+            return inversions % 2 == 0;
+        }
+    }
+}
+
+template <int W, class heuristic>
+void evaluate(search_node<W> &node, const board_tables<W> &goal = tables<W>)
+{
+    if constexpr (heuristic::indexed)
+        node.heuristic_state = heuristic::index(node.board);
+    node.h_n = heuristic::evaluate(node.board, goal);
+    node.priority_value = node.g_n + node.h_n;
+}
+
+// Slides the tile at target into the blank and updates g, h and f.
+// Only one tile moves, so h is patched by the heuristic's delta function
+// instead of rescanning the board.
+template <int W, class heuristic>
+void move_blank(search_node<W> &node, int target, double cost = 1, const board_tables<W> &goal = tables<W>)
+{
+    int from = node.blank;
+    node.board.set(from, node.board.get(target));
+    node.board.set(target, 0);
+    node.blank = target;
+    node.g_n += cost;
+    if constexpr (heuristic::indexed)
+        node.h_n += heuristic::advance(node.heuristic_state, node.board.get(from), target, from);
+    else
+        node.h_n += heuristic::delta(node.board, target, from, goal);
+#ifdef HEURISTIC_DEBUG
+    double full = heuristic::evaluate(node.board, goal);
+    if (fabs(full - node.h_n) > 1e-6)
+    {
+        std::cerr << "heuristic delta mismatch: incremental " << node.h_n << ", full " << full << std::endl;
+        abort();
+    }
+#endif
+    node.priority_value = node.g_n + node.h_n;
+}
+
+// Reverses move_blank: the blank goes back to cell and the saved h and
+// heuristic state are restored instead of being recomputed.
+template <int W>
+void undo_move_blank(search_node<W> &node, int cell, double h_n, uint32_t heuristic_state = 0, double cost = 1)
+{
+    node.board.set(node.blank, node.board.get(cell));
+    node.board.set(cell, 0);
+    node.blank = cell;
+    node.g_n -= cost;
+    node.h_n = h_n;
+    node.heuristic_state = heuristic_state;
+    node.priority_value = node.g_n + node.h_n;
+}
+
+// Blank moves along a chain of parent pointers, from the root to node.
+template <class node_type>
+std::vector<int> parent_moves(const node_type *node)
+{
+    std::vector<int> path;
+    for (; node->parent_node != nullptr; node = node->parent_node)
+    {
+        for (int move = 0; move < MOVE_COUNT; move++)
+        {
+            if (tables<node_type::size>.move_target[node->parent_node->blank][move] == node->blank)
+                path.push_back(move);
+        }
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+// The board after every move, or with compact set the moves of the blank
+// as one line of U, D, L and R. optimal is false for a path only known
+// to be within a bound of the shortest.
+template <int W>
+void print_solution(search_node<W> node, const std::vector<int> &path, bool compact = false, bool optimal = true)
+{
+    std::cout << (optimal ? "Minimum number of moves = " : "Number of moves = ") << path.size() << std::endl;
+    if (compact)
+    {
+        for (int move : path)
+            std::cout << "UDLR"[move];
+        std::cout << std::endl;
+        return;
+    }
+    node.print_current_configuration();
+    std::cout << std::endl;
+    for (int move : path)
+    {
+        int target = tables<W>.move_target[node.blank][move];
+        node.board.set(node.blank, node.board.get(target));
+        node.board.set(target, 0);
+        node.blank = target;
+        node.print_current_configuration();
+        std::cout << std::endl;
+    }
+}
+
+#endif
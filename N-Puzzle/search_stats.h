@@ -0,0 +1,175 @@
+#ifndef SEARCH_STATS_H
+#define SEARCH_STATS_H
+
+#include <iostream>
+
+// Search instrumentation, compiled in with -DSEARCH_STATS. It records time
+// per phase, throughput sampled every SEARCH_STATS_INTERVAL expansions
+// together with the open and closed list sizes, the expansion count at
+// which each new f value was reached, and the peak resident set size, and
+// writes them as one JSON object. Without the switch every call below is an
+// empty inline function, so an uninstrumented build pays nothing.
+//
+// Phases: expand is all of child generation and so contains the other
+// three; heuristic is move_blank (board update plus the h delta); hash is
+// closed list probes; queue is open list pushes and pops.
+
+#define SEARCH_STATS_INTERVAL 65536
+
+enum search_phase
+{
+    PHASE_EXPAND,
+    PHASE_HEURISTIC,
+    PHASE_HASH,
+    PHASE_QUEUE,
+    PHASE_COUNT
+};
+
+#ifdef SEARCH_STATS
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include <sys/resource.h>
+
+class search_stats
+{
+public:
+    void start()
+    {
+        begin = std::chrono::steady_clock::now();
+        last_sample = begin;
+        last_sample_expanded = 0;
+    }
+
+    void add_time(search_phase phase, long long ns)
+    {
+        phase_ns[phase] += ns;
+    }
+
+    void expansion(long long expanded, double f, size_t open, size_t closed)
+    {
+        if (layers.empty() || f > layers.back().f)
+        {
+            layers.push_back({f, expanded, elapsed_ms(std::chrono::steady_clock::now())});
+        }
+        if (expanded % SEARCH_STATS_INTERVAL == 0)
+        {
+            auto now = std::chrono::steady_clock::now();
+            double interval = std::chrono::duration<double>(now - last_sample).count();
+            samples.push_back({expanded, elapsed_ms(now),
+                               interval > 0 ? (expanded - last_sample_expanded) / interval : 0,
+                               open, closed});
+            last_sample = now;
+            last_sample_expanded = expanded;
+        }
+    }
+
+    void write_json(std::ostream &out, const char *heuristic_name, long long expanded, long long explored) const
+    {
+        auto now = std::chrono::steady_clock::now();
+        double total_ms = elapsed_ms(now);
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        char buffer[256];
+
+        out << "{\"heuristic\": \"" << heuristic_name << "\"";
+        snprintf(buffer, sizeof(buffer), ", \"expanded\": %lld, \"explored\": %lld, \"ms\": %.3f, "
+                 "\"nodes_per_sec\": %.0f, \"peak_rss_bytes\": %lld",
+                 expanded, explored, total_ms, total_ms > 0 ? expanded / (total_ms / 1000) : 0,
+                 (long long)usage.ru_maxrss * 1024);
+        out << buffer;
+        snprintf(buffer, sizeof(buffer), ", \"phase_ms\": {\"expand\": %.3f, \"heuristic\": %.3f, "
+                 "\"hash\": %.3f, \"queue\": %.3f}",
+                 phase_ns[PHASE_EXPAND] / 1e6, phase_ns[PHASE_HEURISTIC] / 1e6,
+                 phase_ns[PHASE_HASH] / 1e6, phase_ns[PHASE_QUEUE] / 1e6);
+        out << buffer;
+
+        out << ", \"samples\": [";
+        for (size_t i = 0; i < samples.size(); i++)
+        {
+            snprintf(buffer, sizeof(buffer), "%s{\"expanded\": %lld, \"ms\": %.3f, \"nodes_per_sec\": %.0f, "
+                     "\"open\": %zu, \"closed\": %zu}",
+                     i ? ", " : "", samples[i].expanded, samples[i].ms, samples[i].nodes_per_sec,
+                     samples[i].open, samples[i].closed);
+            out << buffer;
+        }
+        out << "], \"f_layers\": [";
+        for (size_t i = 0; i < layers.size(); i++)
+        {
+            snprintf(buffer, sizeof(buffer), "%s{\"f\": %g, \"expanded\": %lld, \"ms\": %.3f}",
+                     i ? ", " : "", layers[i].f, layers[i].expanded, layers[i].ms);
+            out << buffer;
+        }
+        out << "]}" << std::endl;
+    }
+
+private:
+    struct sample
+    {
+        long long expanded;
+        double ms;
+        double nodes_per_sec;
+        size_t open;
+        size_t closed;
+    };
+    struct f_layer
+    {
+        double f;
+        long long expanded; // expansions before the first node of this f
+        double ms;
+    };
+
+    std::chrono::steady_clock::time_point begin, last_sample;
+    long long last_sample_expanded = 0;
+    long long phase_ns[PHASE_COUNT] = {};
+    std::vector<sample> samples;
+    std::vector<f_layer> layers;
+
+    double elapsed_ms(std::chrono::steady_clock::time_point now) const
+    {
+        return std::chrono::duration<double, std::milli>(now - begin).count();
+    }
+};
+
+// Adds the time until the end of the enclosing scope to a phase.
+class phase_timer
+{
+public:
+    phase_timer(search_stats &stats_, search_phase phase_)
+        : stats(stats_), phase(phase_), begin(std::chrono::steady_clock::now())
+    {
+    }
+    ~phase_timer()
+    {
+        stats.add_time(phase, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                  std::chrono::steady_clock::now() - begin)
+                                  .count());
+    }
+
+private:
+    search_stats &stats;
+    search_phase phase;
+    std::chrono::steady_clock::time_point begin;
+};
+
+#else
+
+class search_stats
+{
+public:
+    void start() {}
+    void add_time(search_phase, long long) {}
+    void expansion(long long, double, size_t, size_t) {}
+    void write_json(std::ostream &, const char *, long long, long long) const {}
+};
+
+class phase_timer
+{
+public:
+    phase_timer(search_stats &, search_phase) {}
+};
+
+#endif
+
+#endif
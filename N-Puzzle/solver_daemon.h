@@ -0,0 +1,319 @@
+#ifndef SOLVER_DAEMON_H
+#define SOLVER_DAEMON_H
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "astar.h"
+#include "batch.h"
+#include "distance_cache.h"
+#include "distance_table.h"
+#include "heuristics.h"
+#include "ida_star.h"
+#include "search_node.h"
+
+// Long-running solver: one request per line ("n" and the n * n tiles, or
+// "stats"), one reply line each, over stdin/stdout or a Unix socket. The
+// heuristic tables are loaded on the first request of a size and stay
+// resident, 3x3 boards come from the distance table, and every optimal
+// path found is kept in a per-size distance_cache. A board on a cached
+// path is answered by replaying it; a search (A*) that reaches a cached
+// board stops there. Requests are solved one at a time on the calling
+// thread, so the caches need no locking; socket clients are multiplexed
+// with poll() and served in arrival order.
+//
+// Replies: "solved <moves> <UDLR or -> <cache|search|search+cache|table>
+// <ms> ms", "not solvable <ms> ms" or an error message.
+
+struct daemon_options
+{
+    std::string engine = "astar";    // astar or ida (the cache then only answers whole requests)
+    std::string socket_path;         // empty: stdin and stdout
+    size_t cache_entries = 1 << 20;  // per board size
+};
+
+template <template <int> class heuristic>
+bool load_heuristic_tables(int size)
+{
+    if constexpr (std::is_same_v<heuristic<4>, pattern_database_distance<4>>)
+        return !pattern_databases[size].patterns.empty() || pattern_databases[size].load(size);
+    else if constexpr (std::is_same_v<heuristic<4>, walking_distance<4>>)
+        return walking_distance_tables[size].build(size);
+    else
+        return true;
+}
+
+template <template <int> class heuristic>
+class solver_daemon
+{
+public:
+    explicit solver_daemon(const daemon_options &options_) : options(options_)
+    {
+        std::apply([&](auto &...cache) { (cache.set_capacity(options.cache_entries), ...); }, caches);
+        use_table = eight_puzzle_table.load();
+    }
+
+    // The reply to one request line, without the newline.
+    std::string handle(const std::string &line)
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::istringstream in(line);
+        std::string word;
+        if (!(in >> word))
+            return "";
+        if (word == "stats")
+            return summary();
+        int n = atoi(word.c_str());
+        std::vector<int> tiles;
+        for (int tile; in >> tile;)
+            tiles.push_back(tile);
+        if (n < 2 || n > MAX_PACKED_SIZE || !is_board_permutation(tiles, n * n))
+            return "invalid board";
+        if (!prepared[n])
+        {
+            if (!load_heuristic_tables<heuristic>(n))
+                return "no heuristic tables for this board size";
+            prepared[n] = true;
+        }
+
+        std::string reply;
+        switch (n)
+        {
+        case 2:
+            reply = solve<2>(tiles);
+            break;
+        case 3:
+            reply = solve<3>(tiles);
+            break;
+        case 4:
+            reply = solve<4>(tiles);
+            break;
+        case 5:
+            reply = solve<5>(tiles);
+            break;
+        case 6:
+            reply = solve<6>(tiles);
+            break;
+        case 7:
+            reply = solve<7>(tiles);
+            break;
+        default:
+            reply = solve<8>(tiles);
+            break;
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        latency.push_back(ms);
+        char elapsed[32];
+        snprintf(elapsed, sizeof(elapsed), " %.3f ms", ms);
+        return reply + elapsed;
+    }
+
+    // Until end of input; the summary goes last.
+    int serve(std::istream &in, std::ostream &out)
+    {
+        std::string line;
+        while (std::getline(in, line))
+        {
+            std::string reply = handle(line);
+            if (!reply.empty())
+                out << reply << std::endl;
+        }
+        out << summary() << std::endl;
+        return 0;
+    }
+
+    // Until killed.
+    int serve(const std::string &path)
+    {
+        int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        if (listener < 0 || path.size() >= sizeof(address.sun_path))
+        {
+            std::cerr << "cannot open socket " << path << std::endl;
+            return 1;
+        }
+        strcpy(address.sun_path, path.c_str());
+        unlink(path.c_str());
+        if (bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || listen(listener, 16) != 0)
+        {
+            std::cerr << "cannot listen on " << path << ": " << strerror(errno) << std::endl;
+            close(listener);
+            return 1;
+        }
+        std::cerr << "Listening on " << path << std::endl;
+
+        std::vector<pollfd> fds(1, {listener, POLLIN, 0});
+        std::vector<std::string> pending(1); // partial request per client
+        char buffer[65536];
+        while (true)
+        {
+            if (poll(fds.data(), fds.size(), -1) < 0)
+            {
+                if (errno == EINTR)
+                    continue; // a signal, not a failure
+                std::cerr << "poll failed: " << strerror(errno) << std::endl;
+                break;
+            }
+            for (size_t i = fds.size(); i-- > 1;)
+            {
+                if (fds[i].revents == 0)
+                    continue;
+                ssize_t count = read(fds[i].fd, buffer, sizeof(buffer));
+                if (count > 0)
+                {
+                    pending[i].append(buffer, count);
+                    size_t end;
+                    while (count > 0 && (end = pending[i].find('\n')) != std::string::npos)
+                    {
+                        std::string reply =
+                            end > max_request_bytes ? "invalid board" : handle(pending[i].substr(0, end));
+                        pending[i].erase(0, end + 1);
+                        if (!reply.empty() && !send_all(fds[i].fd, reply + "\n"))
+                            count = 0;
+                        if (end > max_request_bytes)
+                            count = 0;
+                    }
+                    if (count > 0 && pending[i].size() > max_request_bytes)
+                    {
+                        // a line that can only be invalid; drop the client
+                        // before it grows without bound
+                        send_all(fds[i].fd, "invalid board\n");
+                        count = 0;
+                    }
+                }
+                if (count <= 0)
+                {
+                    close(fds[i].fd);
+                    fds.erase(fds.begin() + i);
+                    pending.erase(pending.begin() + i);
+                }
+            }
+            if (fds[0].revents & POLLIN)
+            {
+                int client = accept(listener, nullptr, nullptr);
+                if (client >= 0)
+                {
+                    fds.push_back({client, POLLIN, 0});
+                    pending.emplace_back();
+                }
+            }
+        }
+        close(listener);
+        return 1;
+    }
+
+private:
+    // an 8x8 request is under 200 bytes
+    static constexpr size_t max_request_bytes = 4096;
+
+    daemon_options options;
+    std::tuple<distance_cache<2>, distance_cache<3>, distance_cache<4>, distance_cache<5>, distance_cache<6>,
+               distance_cache<7>, distance_cache<8>>
+        caches;
+    bool use_table = false;
+    bool prepared[MAX_PACKED_SIZE + 1] = {};
+
+    std::vector<double> latency;
+    long long cache_answers = 0, cut_searches = 0, full_searches = 0, table_answers = 0;
+
+    template <int W>
+    std::string solve(const std::vector<int> &tiles)
+    {
+        search_node<W> node;
+        for (int cell = 0; cell < W * W; cell++)
+        {
+            node.board.set(cell, tiles[cell]);
+            if (tiles[cell] == 0)
+                node.blank = cell;
+        }
+        if (!solvable(node))
+            return "not solvable";
+
+        distance_cache<W> &cache = std::get<W - 2>(caches);
+        std::vector<int> moves;
+        const char *source;
+        long long lookups;
+        if (W == 3 && use_table && solve_with_distance_table(node, moves, lookups))
+        {
+            source = "table";
+            table_answers++;
+        }
+        else if (cache.follow(node, moves))
+        {
+            source = "cache";
+            cache_answers++;
+        }
+        else
+        {
+            bool solved, cut = false;
+            if (options.engine == "ida")
+            {
+                ida_star_solver<W, heuristic<W>> solver;
+                solved = solver.solve(node, moves);
+            }
+            else
+            {
+                astar_solver<W, heuristic<W>> solver;
+                solver.exact = &cache;
+                solved = solver.solve(node, moves);
+                cut = solver.cache_cutoffs > 0;
+            }
+            if (!solved)
+                return "no solution";
+            source = cut ? "search+cache" : "search";
+            (cut ? cut_searches : full_searches)++;
+            cache.store(node, moves);
+        }
+
+        std::string reply = "solved " + std::to_string(moves.size()) + " ";
+        for (int move : moves)
+            reply += "UDLR"[move];
+        if (moves.empty())
+            reply += "-";
+        return reply + " " + source;
+    }
+
+    static bool send_all(int fd, const std::string &data)
+    {
+        for (size_t sent = 0; sent < data.size();)
+        {
+            ssize_t count = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (count <= 0)
+                return false;
+            sent += count;
+        }
+        return true;
+    }
+
+    std::string summary() const
+    {
+        std::vector<double> sorted = latency;
+        std::sort(sorted.begin(), sorted.end());
+        size_t entries = 0, bytes = 0;
+        std::apply([&](const auto &...cache) { ((entries += cache.size(), bytes += cache.bytes()), ...); }, caches);
+        char line[512];
+        snprintf(line, sizeof(line),
+                 "# summary: {\"requests\": %zu, \"cache\": %lld, \"search+cache\": %lld, \"search\": %lld, "
+                 "\"table\": %lld, \"cache_entries\": %zu, \"cache_bytes\": %zu, \"p50_ms\": %.3f, "
+                 "\"p90_ms\": %.3f, \"p99_ms\": %.3f, \"max_ms\": %.3f}",
+                 latency.size(), cache_answers, cut_searches, full_searches, table_answers, entries, bytes,
+                 percentile(sorted, 50), percentile(sorted, 90), percentile(sorted, 99),
+                 sorted.empty() ? 0 : sorted.back());
+        return line;
+    }
+};
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef WALKING_DISTANCE_H
+#define WALKING_DISTANCE_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Walking distance tables. The abstraction keeps, for every row, how many of
+// its tiles belong in each goal row, plus the blank's row; one vertical move
+// takes a tile from the row next to the blank into the blank's row. A BFS
+// from the goal gives the fewest vertical moves for each reachable count
+// matrix. The goal puts the blank in the last row and the last column, so
+// the same table serves columns counted by goal column.
+//
+// For 4x4 there are 24964 count matrices, which keeps an index within 16
+// bits; larger boards have too many to enumerate.
+
+#define WD_MAX_SIZE 4
+
+class walking_distance_table
+{
+public:
+    int size = 0;
+    std::vector<uint8_t> distance; // by table index
+    std::vector<uint16_t> link;    // [index][blank up, blank down][goal line of the moved tile]
+
+    bool build(int size_)
+    {
+        if (size_ < 2 || size_ > WD_MAX_SIZE)
+            return false;
+        if (size == size_)
+            return true;
+        size = size_;
+        distance.clear();
+        index_of.clear();
+
+        std::vector<std::vector<uint8_t>> matrices;
+        std::vector<uint8_t> goal(size * size + 1, 0);
+        for (int line = 0; line < size; line++)
+            goal[line * size + line] = size;
+        goal[size * size - 1] = size - 1;
+        goal[size * size] = size - 1; // blank line
+        index_of[key(goal.data(), size - 1)] = 0;
+        matrices.push_back(goal);
+        distance.push_back(0);
+
+        for (size_t i = 0; i < matrices.size(); i++)
+        {
+            for (int direction = 0; direction < 2; direction++)
+            {
+                for (int goal_line = 0; goal_line < size; goal_line++)
+                {
+                    std::vector<uint8_t> next = matrices[i];
+                    if (!move(next.data(), direction, goal_line))
+                        continue;
+                    uint64_t next_key = key(next.data(), next[size * size]);
+                    if (index_of.count(next_key))
+                        continue;
+                    index_of[next_key] = matrices.size();
+                    matrices.push_back(next);
+                    distance.push_back(distance[i] + 1);
+                }
+            }
+        }
+
+        link.assign(matrices.size() * 2 * size, 0);
+        for (size_t i = 0; i < matrices.size(); i++)
+        {
+            for (int direction = 0; direction < 2; direction++)
+            {
+                for (int goal_line = 0; goal_line < size; goal_line++)
+                {
+                    std::vector<uint8_t> next = matrices[i];
+                    if (move(next.data(), direction, goal_line))
+                        link[(i * 2 + direction) * size + goal_line] = index_of[key(next.data(), next[size * size])];
+                }
+            }
+        }
+        return true;
+    }
+
+    // count[line * size + goal_line] tiles of `line` belong in `goal_line`
+    int index(const uint8_t *count, int blank_line) const
+    {
+        return index_of.at(key(count, blank_line));
+    }
+
+    int next(int index, int direction, int goal_line) const
+    {
+        return link[(index * 2 + direction) * size + goal_line];
+    }
+
+private:
+    std::unordered_map<uint64_t, uint16_t> index_of;
+
+    uint64_t key(const uint8_t *count, int blank_line) const
+    {
+        uint64_t packed = 0;
+        for (int i = 0; i < size * size; i++)
+            packed = packed * (size + 1) + count[i];
+        return packed * size + blank_line;
+    }
+
+    // Moves the blank one line up (0) or down (1), pulling in a tile that
+    // belongs in goal_line. matrix[size * size] is the blank line.
+    bool move(uint8_t *matrix, int direction, int goal_line) const
+    {
+        int blank_line = matrix[size * size];
+        int next_line = direction == 0 ? blank_line - 1 : blank_line + 1;
+        if (next_line < 0 || next_line >= size || matrix[next_line * size + goal_line] == 0)
+            return false;
+        matrix[next_line * size + goal_line]--;
+        matrix[blank_line * size + goal_line]++;
+        matrix[size * size] = next_line;
+        return true;
+    }
+};
+
+#endif